@@ -0,0 +1,136 @@
+#ifndef ALERTS_HPP
+#define ALERTS_HPP
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "snapshot.hpp"
+
+/*  Streaming alert rules, one per line in the --rules file, '#' starts a comment:
+
+        name: [agg(]metric[, window)] op threshold [for duration] [clear threshold]
+              [log path] [exec "command"] [every duration]
+
+        steal_high:  core.steal > 20% for 5s
+        rss_leak:    slope(proc.rss, 60s) > 50MB/min
+        mem_high:    mem > 90% clear 85% log /tmp/mtop-alerts.log
+        hot:         avg(cpu, 10s) > 0.8 exec "logger mtop: cpu hot" every 5m
+
+    metric  cpu mem tcp.retrans | core.util core.user core.system core.iowait core.steal
+            | net.rx net.tx net.errors net.drops (bytes or events/s) | proc.cpu proc.rss (bytes)
+    agg     min max avg slope (per second) over the window, none means the latest value
+    units   % K/KB M/MB G/GB and /s /min /h on thresholds; ms s m h on durations
+
+    A rule fires once its condition held for the `for` duration and stays firing until
+    the value crosses back over `clear` (default: the threshold itself, never past it). Firing runs the
+    actions, at most once per `every` (default 60s) for the rule. Rules are compiled to a
+    fixed plan; windows keep running sums and monotonic queues so each snapshot costs
+    constant time per rule and entity (core, interface or process).
+*/
+class AlertEngine {
+    public:
+        struct Alert {
+            std::string rule;
+            std::string entity;  // "cpu3", "eth0", "1234 java", empty for system rules
+            int pid{0};          // process rules only
+            double value{0.0};
+        };
+
+        AlertEngine() = default;
+        AlertEngine(const AlertEngine&) = delete;
+        AlertEngine& operator=(const AlertEngine&) = delete;
+
+        bool Load(const std::string& path, std::string& error);
+        bool Empty() const;
+        bool NeedsCoreBreakdown() const;
+        void Evaluate(const Snapshot& snap);
+
+        const std::vector<Alert>& Firing() const;
+        const std::unordered_set<int>& FiringPids() const;
+
+        enum class Scope { kSystem, kCore, kNet, kProcess };
+        enum class Metric {
+            kCpu, kMem, kTcpRetrans,
+            kCoreUtil, kCoreUser, kCoreSystem, kCoreIOwait, kCoreSteal,
+            kNetRx, kNetTx, kNetErrors, kNetDrops,
+            kProcCpu, kProcRss
+        };
+        enum class Agg { kValue, kMin, kMax, kAvg, kSlope };
+
+    private:
+        // sliding time window with O(1) amortized min/max/avg/slope in fixed storage
+        class Window {
+            public:
+                // a window never holds more samples than this, closer pushes are skipped
+                static constexpr int kSamples = 128;
+
+                void Push(double t, double v, double span);
+                double Min() const;
+                double Max() const;
+                double Avg() const;
+                double Slope() const;  // least squares, units per second
+            private:
+                struct Sample { double t, v; };
+                // monotonic queue of ring slots, oldest at the front
+                struct SlotQueue {
+                    unsigned char slots[kSamples];
+                    int head{0};
+                    int count{0};
+                    int Front() const { return slots[head]; }
+                    int Back() const { return slots[(head + count - 1) % kSamples]; }
+                    void PushBack(int slot) { slots[(head + count++) % kSamples] = static_cast<unsigned char>(slot); }
+                    void PopBack() { --count; }
+                    void PopFront() { head = (head + 1) % kSamples; --count; }
+                };
+
+                void PopFront();
+
+                Sample samples_[kSamples];
+                int head_{0};
+                int count_{0};
+                SlotQueue min_, max_;
+                double sum_t_{0}, sum_v_{0}, sum_tt_{0}, sum_tv_{0};
+                double origin_{-1};
+                double last_push_{-1};
+        };
+
+        struct EntityState {
+            std::unique_ptr<Window> window;  // aggregated rules only
+            double pending_since{-1};
+            bool firing{false};
+            unsigned seen{0};
+        };
+
+        struct Plan {
+            std::string name;
+            Scope scope;
+            Metric metric;
+            Agg agg{Agg::kValue};
+            double window{0};
+            bool above{true};  // > or <
+            double threshold{0};
+            double clear{0};
+            double hold{0};  // the `for` duration
+            double every{60};
+            std::string log_path;
+            std::string command;
+            double last_action{-1e18};
+            std::unordered_map<long long, EntityState> entities;
+        };
+
+        // name: "cpu" for cores, the interface name, or the process command line
+        void Step(Plan& plan, long long key, const std::string& name, double value, double now);
+        void Act(Plan& plan, const std::string& entity, double value, double now);
+        void Reap();
+
+        std::vector<Plan> plans_;
+        std::vector<Alert> firing_;
+        std::unordered_set<int> firing_pids_;
+        unsigned epoch_{0};
+        int children_{0};
+};
+
+#endif
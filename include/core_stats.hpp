@@ -0,0 +1,43 @@
+#ifndef CORE_STATS_HPP
+#define CORE_STATS_HPP
+
+#include <string>
+#include <vector>
+
+#include "linux_parser.hpp"
+
+/*  Utilization of every cpu line in /proc/stat, index 0 is the whole machine and
+    index i + 1 is cpu i. Counters are kept as structure-of-arrays in a prev/curr pair
+    that is swapped each Update(), and all lanes are computed by one vectorizable pass.
+    With breakdown enabled the same pass also fills the user/system/iowait/steal shares
+    (user excludes guest time, which the kernel already folds into user and nice).
+*/
+class CoreStats {
+    public:
+        explicit CoreStats(bool breakdown = false);
+        ~CoreStats();
+        CoreStats(const CoreStats&) = delete;
+        CoreStats& operator=(const CoreStats&) = delete;
+
+        bool Update();
+        size_t Count() const;
+        const std::vector<float>& Utilization() const;
+        const std::vector<int>& CpuIds() const;  // cpu id per index, -1 at index 0
+        const std::vector<float>& User() const;
+        const std::vector<float>& System() const;
+        const std::vector<float>& IOwait() const;
+        const std::vector<float>& Steal() const;
+
+    private:
+        int fd_{-1};
+        bool breakdown_{false};
+        bool primed_{false};
+        std::string buffer_;
+        LinuxParser::CpuTimesSoA times_[2];
+        int curr_{0};
+
+        std::vector<float> util_;
+        std::vector<float> user_, system_, iowait_, steal_;
+};
+
+#endif
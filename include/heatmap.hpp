@@ -0,0 +1,33 @@
+#ifndef HEATMAP_HPP
+#define HEATMAP_HPP
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <ftxui/dom/elements.hpp>
+
+/*  Compact per-core view: one half-cell per core per time column, colored by utilization.
+    Cores are drawn in the given order, a new group (NUMA node) starts on a fresh row with
+    its label in the gutter. When the cores don't fit the height they wrap into side by
+    side bands, and only when the bands would get too narrow are neighbouring cores
+    merged (max) into one half-cell. The layout is fixed when the element is built, for the
+    area of the previous frame, and everything is drawn straight into the screen buffer,
+    so the cost follows the screen area rather than cores x history length.
+*/
+namespace Heatmap {
+    // the box the heatmap was drawn into on the previous frame, kept by the caller across frames
+    struct Area {
+        int width{0};
+        int height{0};
+    };
+
+    // history: per core samples (oldest first), order: core indices to draw, group: group id per entry of order.
+    // only the values on screen are copied, history may change once this returns
+    ftxui::Element Render(const std::vector<std::deque<float>>& history,
+                          const std::vector<int>& order,
+                          const std::vector<int>& group,
+                          std::shared_ptr<Area> area);
+}; // namespace Heatmap
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef SYSTEM_PARSER_HPP
 #define SYSTEM_PARSER_HPP
 
+#include <array>
+#include <cstdint>
 #include <fstream>
 #include <regex>
 #include <string>
@@ -13,11 +15,16 @@ namespace LinuxParser {
     const std::string kCpuinfoFilename{"/cpuinfo"};
     const std::string kStatusFilename{"/status"};
     const std::string kStatFilename{"/stat"};
+    const std::string kTaskDirectory{"/task/"};
     const std::string kUptimeFilename{"/uptime"};
     const std::string kMeminfoFilename{"/meminfo"};
     const std::string kVersionFilename{"/version"};
+    const std::string kNetDevFilename{"/net/dev"};
+    const std::string kNetSnmpFilename{"/net/snmp"};
     const std::string kOSPath{"/etc/os-release"};
     const std::string kPasswordPath{"/etc/passwd"};
+    const std::string kNodeDirectory{"/sys/devices/system/node/"};
+    const std::string kCpulistFilename{"/cpulist"};
 
     float MemoryUtilization();
     long UpTime();
@@ -50,18 +57,66 @@ namespace LinuxParser {
         kGuestNice_
     };
 
-    struct CpuTimes {
-        long user{0}, nice{0}, system{0}, idle{0}, iowait{0}, irq{0}, softirq{0}, steal{0};
+    /*  every cpu line of /proc/stat as structure-of-arrays, column[kUser_][0] is the
+        aggregate "cpu" line and column[kUser_][i + 1] is cpu i. Only the low 32 bits of
+        each counter are kept: deltas are taken with unsigned wrap-around, which is exact
+        as long as a single interval stays below 2^32 ticks, and keeps the kernel in
+        32 bit lanes.
+    */
+    struct CpuTimesSoA {
+        std::array<std::vector<uint32_t>, kGuestNice_ + 1> column;
+        std::vector<int> cpu;  // N of the "cpuN" label, -1 for the aggregate line
+        size_t Size() const { return column[kUser_].size(); }
+        void Resize(size_t n) {
+            for (auto& c : column) c.resize(n);
+            cpu.resize(n);
+        }
     };
 
     std::vector<std::string> CpuUtilization();
-    bool ReadCpuTimesAll(std::vector<CpuTimes>& out);
-    float UtilFromData(const CpuTimes& prev, const CpuTimes& curr);
+    bool ParseCpuTimes(const std::string& content, CpuTimesSoA& out);
+    // NUMA node of every cpu id from /sys/devices/system/node/node*/cpulist, empty without NUMA info
+    std::vector<int> CpuNodes();
     long Jiffies();
     long ActiveJiffies();
     long ActiveJiffies(int pid);
     long IdleJiffies();
 
+    /*  /proc/net/dev columns we keep per interface (cumulative since boot)
+        bytes	 bytes received / transmitted
+        packets	 packets received / transmitted
+        errs	 receive / transmit errors reported by the driver
+        drop	 packets dropped by the kernel or driver
+    */
+    struct NetDevCounters {
+        std::string name;
+        unsigned long long rx_bytes{0}, rx_packets{0}, rx_errs{0}, rx_drop{0};
+        unsigned long long tx_bytes{0}, tx_packets{0}, tx_errs{0}, tx_drop{0};
+    };
+
+    // pread() from offset 0 into buf (grown as needed), buf.size() is the content length
+    bool ReadFd(int fd, std::string& buf);
+    bool ParseNetDev(const std::string& content, std::vector<NetDevCounters>& out);
+    bool ParseTcpRetransSegs(const std::string& content, unsigned long long& out);
+
+    // the /proc/[pid]/stat (or /proc/[pid]/task/[tid]/stat) fields mtop uses, see ActiveJiffies(pid)
+    struct ProcStat {
+        std::string comm;
+        char state{'?'};
+        long utime{0}, stime{0}, cutime{0}, cstime{0};
+        long long starttime{0};  // clock ticks after boot
+        long rss{0};             // pages
+        int processor{-1};       // cpu it last ran on
+    };
+
+    // open + pread + close into a reused buffer
+    bool ReadPath(const char* path, std::string& buf);
+    bool ParseProcStat(const std::string& content, ProcStat& out);
+    bool ParseProcIo(const std::string& content, unsigned long long& read_bytes, unsigned long long& write_bytes);
+    std::string UserByUid(const std::string& uid);
+    // thread ids of pid from /proc/[pid]/task into a reused vector, false once the process is gone
+    bool Tids(int pid, std::vector<int>& out);
+
     std::string Command(int pid);
     std::string Ram(int pid);
     std::string Uid(int pid);
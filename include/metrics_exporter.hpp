@@ -0,0 +1,61 @@
+#ifndef METRICS_EXPORTER_HPP
+#define METRICS_EXPORTER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "snapshot.hpp"
+
+/*  OpenMetrics text endpoint on 127.0.0.1 for a local Prometheus scraper.
+    The exposition is rendered once per sampling cycle by Publish() into a reusable
+    buffer and swapped in; a scrape only grabs the current buffer and writes it out,
+    it never touches procfs, so any number of scrapers adds no sampling cost. Connections
+    are multiplexed with poll, a client that stalls only holds its own slot until it times out.
+    Process series are limited to the top N rows to keep label cardinality bounded.
+*/
+class MetricsExporter {
+    public:
+        static constexpr int kDefaultPort = 9164;
+        static constexpr size_t kDefaultTopProcesses = 10;
+
+        MetricsExporter(int port, size_t top_processes);
+        ~MetricsExporter();
+        MetricsExporter(const MetricsExporter&) = delete;
+        MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+        bool Listen(std::string& error);
+        void Publish(const Snapshot& snap);
+
+    private:
+        // one pending connection: reading the request, then writing the reply
+        struct Client {
+            int fd;
+            std::chrono::steady_clock::time_point deadline;
+            std::string request;
+            std::string header;
+            std::shared_ptr<std::string> body;  // set once the request is complete
+            size_t sent{0};
+        };
+
+        void Serve();
+        // false once the client is done (answered, gone or broken) and can be closed
+        bool Read(Client& client);
+        bool Write(Client& client);
+
+        int port_;
+        size_t top_processes_;
+        int listen_fd_{-1};
+        std::atomic<bool> running_{false};
+        std::thread thread_;
+
+        std::mutex mtx_;
+        std::shared_ptr<std::string> current_;  // what scrapes get
+        std::shared_ptr<std::string> spare_;    // rendered into next, reused once no scrape holds it
+};
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef MTOP_SHM_HPP
+#define MTOP_SHM_HPP
+
+/*  Reader side of the snapshot ring mtop publishes with --shm (default /dev/shm/mtop).
+    Self contained on purpose: copy this header into any local tool.
+
+    The file is one fixed layout Region: a header and kSlots slots, each slot guarded by
+    a seqlock (odd sequence = being written). mtop fills the slots round robin and bumps
+    header.latest after each one, so a reader just maps the file and looks at the slot
+    of the latest snapshot in place: no syscalls and no copies after Open().
+
+        MtopShm::Reader reader;
+        if (reader.Open()) {  // or Open(path, uid of the mtop writing it)
+            reader.Read([](const MtopShm::Snapshot& s) { use(s.total_cpu, s.cores[0]); });
+        }
+
+    The callback may run more than once (a retry after a concurrent write) and must not
+    keep pointers into the snapshot, nor trust values until Read() returned true.
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace MtopShm {
+    const char* const kDefaultPath = "/dev/shm/mtop";
+    const uint32_t kMagic = 0x504f544d;  // "MTOP"
+    const uint32_t kVersion = 2;
+    const uint32_t kSlots = 4;
+    const uint32_t kMaxCores = 1024;
+    const uint32_t kMaxInterfaces = 64;
+    const uint32_t kMaxProcesses = 256;
+
+    struct Interface {
+        char name[16];                 // NUL terminated
+        uint32_t active;
+        uint32_t generation;           // changes when the slot is handed to another interface
+        float rx_bytes, tx_bytes;      // bytes/s
+        float rx_packets, tx_packets;  // packets/s
+        float errors, drops;           // rx + tx per second
+    };
+
+    struct Process {
+        int32_t pid;
+        float cpu;  // fraction of one cpu
+        int64_t ram_kb;
+        char user[32];      // NUL terminated, truncated
+        char command[128];  // NUL terminated, truncated
+    };
+
+    struct Snapshot {
+        uint64_t seq;
+        int64_t uptime;  // seconds
+        float total_cpu;
+        float mem_used;
+        float tcp_retrans;  // segments/s
+        uint32_t core_count;
+        uint32_t interface_count;
+        uint32_t process_count;  // top processes by cpu
+        float cores[kMaxCores];       // per online cpu
+        int32_t core_ids[kMaxCores];  // cpu number of cores[i], offline cpus are skipped
+        int32_t core_nodes[kMaxCores];
+        Interface interfaces[kMaxInterfaces];
+        Process processes[kMaxProcesses];
+    };
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> sequence;
+        Snapshot data;
+    };
+
+    struct alignas(64) Header {
+        uint32_t magic;  // written last, a reader seeing it can trust the rest
+        uint32_t version;
+        uint32_t slot_count;
+        uint32_t slot_size;
+        std::atomic<uint64_t> latest;  // snapshots published so far, the newest is in slot latest % slot_count
+    };
+
+    struct Region {
+        Header header;
+        Slot slots[kSlots];
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "the ring needs address free atomics");
+
+    class Reader {
+        public:
+            Reader() = default;
+            ~Reader() {
+                if (region_) munmap(const_cast<Region*>(region_), sizeof(Region));
+            }
+            Reader(const Reader&) = delete;
+            Reader& operator=(const Reader&) = delete;
+
+            // owner: the uid the writer must run as, anyone could create the file first.
+            // root owned rings are trusted as well
+            bool Open(const std::string& path = kDefaultPath, uid_t owner = geteuid()) {
+                int fd = open(path.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+                if (fd < 0) return false;
+                struct stat st;
+                void* map = MAP_FAILED;
+                if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && (st.st_uid == owner || st.st_uid == 0) &&
+                    static_cast<size_t>(st.st_size) >= sizeof(Region)) {
+                    map = mmap(nullptr, sizeof(Region), PROT_READ, MAP_SHARED, fd, 0);
+                }
+                close(fd);
+                if (map == MAP_FAILED) return false;
+                const Region* region = static_cast<const Region*>(map);
+                const Header& h = region->header;
+                if (h.magic != kMagic || h.version != kVersion || h.slot_count != kSlots || h.slot_size != sizeof(Slot)) {
+                    munmap(map, sizeof(Region));
+                    return false;
+                }
+                region_ = region;
+                return true;
+            }
+
+            // changes with every published snapshot, 0 before the first one, cheap enough to poll
+            uint64_t Latest() const { return region_ ? region_->header.latest.load(std::memory_order_acquire) : 0; }
+
+            template <class F>
+            bool Read(F&& f, int attempts = 16) const {
+                if (!region_) return false;
+                for (int i = 0; i < attempts; ++i) {
+                    uint64_t latest = Latest();
+                    if (latest == 0) return false;
+                    const Slot& slot = region_->slots[latest % kSlots];
+                    uint64_t before = slot.sequence.load(std::memory_order_acquire);
+                    if (before & 1) continue;
+                    f(slot.data);
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (slot.sequence.load(std::memory_order_relaxed) == before) return true;
+                }
+                return false;
+            }
+
+        private:
+            const Region* region_{nullptr};
+    };
+}; // namespace MtopShm
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef NETWORK_HPP
+#define NETWORK_HPP
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "linux_parser.hpp"
+
+/*  Per interface throughput from /proc/net/dev (and TCP retransmits from /proc/net/snmp).
+    Interfaces live in slots that keep their index for as long as the interface exists,
+    a vanished interface frees its slot for the next newcomer, so veth churn on container
+    hosts recycles slots instead of reshuffling (and reallocating) the whole table.
+*/
+class Network {
+    public:
+        struct Interface {
+            std::string name;
+            bool active{false};
+            unsigned generation{0};                 // bumped every time the slot gets a new interface
+            float rx_bytes{0.f}, tx_bytes{0.f};      // bytes/s
+            float rx_packets{0.f}, tx_packets{0.f};  // packets/s
+            float errors{0.f}, drops{0.f};           // rx + tx per second
+        };
+
+        explicit Network(bool tcp_retransmits = true);
+        ~Network();
+        Network(const Network&) = delete;
+        Network& operator=(const Network&) = delete;
+
+        bool Update();
+        const std::vector<Interface>& Interfaces() const;
+        float TcpRetransmits() const;  // segments/s
+
+    private:
+        size_t SlotFor(const std::string& name, size_t hint);
+
+        int dev_fd_{-1};
+        int snmp_fd_{-1};
+        std::string buffer_;
+        std::vector<LinuxParser::NetDevCounters> counters_;
+
+        std::vector<Interface> interfaces_;
+        std::vector<LinuxParser::NetDevCounters> prev_;
+        std::vector<bool> seen_;
+        std::unordered_map<std::string, size_t> index_;
+
+        unsigned long long prev_retrans_{0};
+        float tcp_retrans_{0.f};
+        std::chrono::steady_clock::time_point last_{};
+        bool primed_{false};
+};
+
+#endif
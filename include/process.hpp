@@ -2,21 +2,62 @@
 #define PROCESS_HPP
 
 #include <string>
+#include <unordered_map>
 #include <unistd.h>
 
+#include "linux_parser.hpp"
+
+// one cached entry per live pid, owned by System. Update() only re-reads /proc/[pid]/stat
+// (and /io), the user and command line are loaded once and again only after an exec or pid reuse
 class Process {
     public:
         explicit Process(int pid);
-        int Pid();
-        std::string User();
-        std::string Command();
-        float CpuUtilization();
-        std::string Ram();
-        long int UpTime();
+        int Pid() const;
+        const std::string& User() const;
+        const std::string& Command() const;
+        float CpuUtilization() const; // fraction of one cpu over the last interval (lifetime share until the first)
+        long RamKb() const;
+        long int UpTime() const;      // seconds since the process started
+        long StartTime() const;       // seconds after boot it started at
+        float IoRate() const;         // bytes/s read + written, -1 when /proc/[pid]/io is not readable
+        unsigned Generation() const;  // changes whenever user and command are reloaded
         bool operator<(Process const& a) const;
-    
+
     private:
-        int pid_{0};        
+        friend class System;
+
+        // per cycle values shared by every entry
+        struct Cycle {
+            long uptime{0};
+            double now{0.0};  // monotonic seconds
+            long hertz{100};
+            long page_kb{4};
+            std::string buf;  // scratch for the file reads
+            LinuxParser::ProcStat stat;
+            std::unordered_map<std::string, std::string> users;  // uid -> name
+            unsigned loads{0};  // Load() calls so far, hands out the generations
+        };
+
+        // false once the pid is gone
+        bool Update(Cycle& cycle);
+        void Load(Cycle& cycle);
+
+        int pid_{0};
+        std::string user_;
+        std::string command_;
+        std::string comm_;
+        unsigned generation_{0};
+        long long starttime_{-1};
+        long uptime_{0};
+        long start_{0};
+        float cpu_{0.f};
+        long cpu_ticks_{0};        // utime + stime at cpu_time_
+        double cpu_time_{0.0};
+        long ram_kb_{0};
+        bool io_readable_{true};
+        unsigned long long io_bytes_{0};
+        double io_time_{0.0};
+        float io_rate_{-1.f};
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,62 @@
+#ifndef PROCESS_VIEW_HPP
+#define PROCESS_VIEW_HPP
+
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "snapshot.hpp"
+
+// display order of the process table: a filter over the command/user strings the snapshot
+// already carries, and a sort that starts from the previous order so a refresh of a mostly
+// unchanged list stays close to linear (see Utils::AdaptiveSort)
+class ProcessView {
+    public:
+        enum class Key { kCpu, kRam, kPid, kUser, kStart, kIo };
+
+        // picking the current key again flips the direction
+        void SortBy(Key key);
+        Key SortKey() const;
+        bool Descending() const;
+
+        // substring match on command or user, or a regular expression after "re:".
+        // false on a bad expression, the previous filter then stays active
+        bool SetFilter(const std::string& filter, std::string& error);
+        const std::string& Filter() const;
+
+        // recompute the order for a new (or the same) process list
+        void Update(const std::vector<ProcessRow>& rows);
+        // indices into the rows last passed to Update(), in display order
+        const std::vector<int>& Rows() const;
+
+    private:
+        // a verdict holds while the pid keeps its user and command (generation)
+        struct Verdict {
+            unsigned generation;
+            bool match;
+        };
+        bool Matches(const ProcessRow& row);
+
+        Key key_{Key::kCpu};
+        bool descending_{true};
+        std::string filter_;
+        bool regex_{false};
+        std::regex pattern_;
+        std::unordered_map<int, Verdict> verdicts_;  // pid -> verdict for filter_
+
+        // pid -> index into the current rows, updated in place; entries not seen in this
+        // Update() are the exited pids and get swept
+        struct Slot {
+            int index;
+            unsigned seen;
+        };
+
+        std::vector<int> order_;  // pids, last display order
+        std::vector<int> rows_;
+        std::unordered_map<int, Slot> slot_;
+        unsigned epoch_{0};
+        std::vector<char> placed_;
+};
+
+#endif
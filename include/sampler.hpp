@@ -0,0 +1,28 @@
+#ifndef SAMPLER_HPP
+#define SAMPLER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "core_stats.hpp"
+#include "network.hpp"
+#include "snapshot.hpp"
+#include "system.hpp"
+
+// one procfs pass per call, shared by the local UI and the --serve daemon
+class Sampler {
+    public:
+        // breakdown: also fill the per core user/system/iowait/steal shares
+        explicit Sampler(bool breakdown = false);
+        void Sample(Snapshot& out);
+
+    private:
+        System sys_;
+        bool breakdown_;
+        CoreStats cores_;
+        Network net_;
+        std::vector<int> cpu_nodes_;
+        uint64_t seq_{0};
+};
+
+#endif
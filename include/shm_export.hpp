@@ -0,0 +1,28 @@
+#ifndef SHM_EXPORT_HPP
+#define SHM_EXPORT_HPP
+
+#include <string>
+
+#include "mtop_shm.hpp"
+#include "snapshot.hpp"
+
+// writer side of the --shm ring, see mtop_shm.hpp for the layout and the reader
+class ShmExporter {
+    public:
+        explicit ShmExporter(std::string path);
+        ~ShmExporter();
+        ShmExporter(const ShmExporter&) = delete;
+        ShmExporter& operator=(const ShmExporter&) = delete;
+
+        // false if the path is a symlink, not ours, or another mtop is already exporting to it
+        bool Open(std::string& error);
+        void Publish(const Snapshot& snap);
+
+    private:
+        std::string path_;
+        int fd_{-1};  // held open for its flock, the writer's claim on the ring
+        MtopShm::Region* region_{nullptr};
+        uint64_t published_{0};
+};
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "network.hpp"
+
+struct ProcessRow {
+    int pid{0};
+    float cpu{0.f};  // fraction of one cpu over about the last second
+    long ram_kb{0};
+    long start{0};    // seconds after boot
+    float io{-1.f};   // bytes/s read + written, -1 when unknown
+    std::string user;
+    std::string command;
+    unsigned generation{0};  // bumped every time user and command are reloaded
+};
+
+// everything one sampling cycle produces, the UI and the exporters only ever see this
+struct Snapshot {
+    uint64_t seq{0};
+    float total_cpu{0.f};
+    float mem_used{0.f};
+    long uptime{0};
+
+    // per online cpu: /proc/stat skips offline ones, so index i is cpu core_ids[i]
+    std::vector<float> cores;
+    std::vector<int> core_ids;
+    std::vector<int> core_nodes;  // NUMA node of cores[i]
+    // per cpu time shares, only filled when the sampler computes the breakdown
+    std::vector<float> core_user, core_system, core_iowait, core_steal;
+
+    std::vector<Network::Interface> interfaces;  // indexed by Network slot
+    float tcp_retrans{0.f};
+
+    std::vector<ProcessRow> procs;
+};
+
+/*  Compact binary form used by --serve/--attach. A keyframe carries the whole snapshot,
+    a delta only what changed against the previous snapshot: per core differences as
+    zigzag varints (utilization and the optional breakdown), interfaces whose rates moved, and processes added/changed/removed by pid.
+    Unchanged processes cost nothing, their order travels as runs over the previous order.
+    Fractions travel as 1/10000 steps and rates as whole units, so the decoded snapshot
+    is the quantized server one and later deltas stay exact.
+*/
+namespace SnapshotCodec {
+    const uint8_t kVersion = 6;
+
+    // prev == nullptr encodes a keyframe
+    void Encode(const Snapshot& curr, const Snapshot* prev, std::string& out);
+    // applies a keyframe or a delta onto state, false if the message is malformed or out of order
+    // (state is then reset and only a keyframe can pick up again)
+    bool Decode(const char* data, size_t size, Snapshot& state);
+}; // namespace SnapshotCodec
+
+#endif
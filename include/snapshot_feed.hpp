@@ -0,0 +1,70 @@
+#ifndef SNAPSHOT_FEED_HPP
+#define SNAPSHOT_FEED_HPP
+
+#include <string>
+#include <vector>
+
+#include "snapshot.hpp"
+
+/*  --serve / --attach transport over a Unix domain socket. Frames are a 4 byte little
+    endian length followed by a SnapshotCodec message. Every cycle the server encodes one
+    delta (and one keyframe only if some viewer needs it) and hands the same bytes to
+    every viewer, so extra viewers only cost a send() each. A viewer that can't keep up
+    skips deltas and is resynced with a keyframe once its socket drains.
+*/
+namespace SnapshotFeed {
+    // /tmp/mtop.sock unless overridden, readable by every local user like /proc itself
+    const std::string kDefaultSocketPath{"/tmp/mtop.sock"};
+}; // namespace SnapshotFeed
+
+class SnapshotServer {
+    public:
+        explicit SnapshotServer(std::string path);
+        ~SnapshotServer();
+        SnapshotServer(const SnapshotServer&) = delete;
+        SnapshotServer& operator=(const SnapshotServer&) = delete;
+
+        bool Listen(std::string& error);
+        void Publish(const Snapshot& snap);
+        size_t Viewers() const;
+
+    private:
+        struct Viewer {
+            int fd{-1};
+            bool needs_keyframe{true};
+            std::string pending;  // unsent tail of the last frame
+        };
+
+        void Accept();
+        bool Flush(Viewer& viewer);
+
+        std::string path_;
+        int listen_fd_{-1};
+        std::vector<Viewer> viewers_;
+        Snapshot prev_;
+        bool have_prev_{false};
+        std::string keyframe_;
+        std::string delta_;
+};
+
+class SnapshotClient {
+    public:
+        explicit SnapshotClient(std::string path);
+        ~SnapshotClient();
+        SnapshotClient(const SnapshotClient&) = delete;
+        SnapshotClient& operator=(const SnapshotClient&) = delete;
+
+        // false as well when the server runs as another (non root) user
+        bool Connect(std::string& error);
+        // blocks for the next frame and applies it to snap, false once the feed is gone
+        bool Receive(Snapshot& snap);
+        // wakes up a Receive() blocked in another thread
+        void Shutdown();
+
+    private:
+        std::string path_;
+        int fd_{-1};
+        std::string buffer_;
+};
+
+#endif
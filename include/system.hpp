@@ -2,6 +2,7 @@
 #define SYSTEM_HPP
 
 #include <string>
+#include <unordered_set>
 #include <vector>
 #include <algorithm>
 
@@ -11,6 +12,8 @@
 class System {
   public:
     Processor& Cpu();
+    // every live process, highest interval cpu share first. Entries persist across calls,
+    // so each call is one stat read per pid plus cmdline/status for the new ones
     std::vector<Process>& Processes();
     float MemoryUtilization();
     long UpTime();
@@ -22,6 +25,9 @@ class System {
   private:
     Processor cpu_ = {};
     std::vector<Process> processes_ = {};
+    std::vector<Process> spare_ = {};
+    std::unordered_set<int> known_ = {};  // pids already holding an entry
+    Process::Cycle cycle_ = {};
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef TASK_TABLE_HPP
+#define TASK_TABLE_HPP
+
+#include <string>
+#include <vector>
+
+#include "linux_parser.hpp"
+
+// the threads of one process from /proc/[pid]/task, only kept (and scanned) while the process
+// is expanded in the UI. Entries stay sorted by tid and are updated in place, so a process with
+// thousands of threads costs no allocations per refresh once its table has grown.
+class TaskTable {
+    public:
+        struct Thread {
+            int tid{0};
+            std::string name;
+            char state{'?'};
+            int processor{-1};  // cpu it last ran on
+            float cpu{0.f};     // fraction of one cpu since the previous Update()
+        };
+
+        explicit TaskTable(int pid);
+        // rescans the task directory, false once the process is gone
+        bool Update();
+        int Pid() const;
+        const std::vector<Thread>& Threads() const;  // by tid
+        // indices into Threads(), busiest first
+        const std::vector<int>& ByCpu() const;
+
+    private:
+        // what the interval cpu share is computed from, parallel to threads_
+        struct Sample {
+            long long starttime{-1};
+            unsigned long long ticks{0};
+        };
+        bool Read(size_t slot, double dt);
+
+        int pid_;
+        long hertz_;
+        double last_{0.0};  // monotonic seconds of the previous Update()
+        std::vector<Thread> threads_;
+        std::vector<Sample> samples_;
+        std::vector<int> by_cpu_;
+        std::vector<int> tids_;
+        std::string buf_;
+        LinuxParser::ProcStat stat_;
+};
+
+#endif
@@ -1,14 +1,58 @@
 #ifndef UTILS_HPP
 #define UTILS_HPP
 
+#include <algorithm>
+#include <iterator>
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include <vector>
 
 namespace Utils {
     //  input:  Long int measuring seconds 
     // output:  HH::MM::SS 
     std::string ElapsedTime(long times); 
+    //  input:  amount in bytes (or any count)
+    // output:  short human readable form like 12.3K, 1.2M
+    std::string HumanBytes(double bytes);
+
+    // natural merge sort: finds the already ordered runs and merges them pairwise, so a range
+    // that is still mostly in last cycle's order costs close to one linear pass. Falls back to
+    // std::sort when the input is too shuffled to be worth it.
+    template <class It, class Less>
+    void AdaptiveSort(It first, It last, Less less) {
+        const auto n = std::distance(first, last);
+        if (n < 2) return;
+        std::vector<It> bounds{first};
+        for (It i = first; i != last;) {
+            It j = std::next(i);
+            if (j != last && less(*j, *i)) {
+                // strictly descending, reversing keeps equal elements in order
+                while (j != last && less(*j, *std::prev(j))) ++j;
+                std::reverse(i, j);
+            } else {
+                while (j != last && !less(*j, *std::prev(j))) ++j;
+            }
+            bounds.push_back(j);
+            i = j;
+            if (static_cast<long>(bounds.size()) > n / 8 + 2) {
+                std::sort(first, last, less);
+                return;
+            }
+        }
+        std::vector<It> merged;
+        while (bounds.size() > 2) {
+            merged.clear();
+            size_t k = 0;
+            for (; k + 2 < bounds.size(); k += 2) {
+                std::inplace_merge(bounds[k], bounds[k + 1], bounds[k + 2], less);
+                merged.push_back(bounds[k]);
+            }
+            if (k + 1 < bounds.size()) merged.push_back(bounds[k]);
+            merged.push_back(last);
+            bounds.swap(merged);
+        }
+    }
 };
 
 #endif 
\ No newline at end of file
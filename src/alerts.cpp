@@ -0,0 +1,394 @@
+#include "../include/alerts.hpp"
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <spawn.h>
+#include <sys/wait.h>
+
+extern char** environ;
+
+namespace {
+    using Scope = AlertEngine::Scope;
+    using Metric = AlertEngine::Metric;
+    using Agg = AlertEngine::Agg;
+
+    struct MetricName {
+        const char* name;
+        Scope scope;
+        Metric metric;
+    };
+
+    const MetricName kMetrics[] = {
+        {"cpu", Scope::kSystem, Metric::kCpu},
+        {"mem", Scope::kSystem, Metric::kMem},
+        {"tcp.retrans", Scope::kSystem, Metric::kTcpRetrans},
+        {"core.util", Scope::kCore, Metric::kCoreUtil},
+        {"core.user", Scope::kCore, Metric::kCoreUser},
+        {"core.system", Scope::kCore, Metric::kCoreSystem},
+        {"core.iowait", Scope::kCore, Metric::kCoreIOwait},
+        {"core.steal", Scope::kCore, Metric::kCoreSteal},
+        {"net.rx", Scope::kNet, Metric::kNetRx},
+        {"net.tx", Scope::kNet, Metric::kNetTx},
+        {"net.errors", Scope::kNet, Metric::kNetErrors},
+        {"net.drops", Scope::kNet, Metric::kNetDrops},
+        {"proc.cpu", Scope::kProcess, Metric::kProcCpu},
+        {"proc.rss", Scope::kProcess, Metric::kProcRss},
+    };
+
+    // words, quoted strings, and ( ) , : as tokens of their own
+    bool Tokenize(const std::string& line, std::vector<std::string>& out) {
+        out.clear();
+        size_t i = 0;
+        while (i < line.size()) {
+            char c = line[i];
+            if (std::isspace(static_cast<unsigned char>(c))) {
+                ++i;
+            } else if (c == '#') {
+                break;
+            } else if (c == '"') {
+                size_t end = line.find('"', i + 1);
+                if (end == std::string::npos) return false;
+                out.push_back(line.substr(i, end - i + 1));
+                i = end + 1;
+            } else if (c == '(' || c == ')' || c == ',' || c == ':') {
+                out.emplace_back(1, c);
+                ++i;
+            } else {
+                size_t start = i;
+                while (i < line.size() && !std::isspace(static_cast<unsigned char>(line[i])) &&
+                       line[i] != '(' && line[i] != ')' && line[i] != ',' && line[i] != ':' && line[i] != '"') {
+                    ++i;
+                }
+                out.push_back(line.substr(start, i - start));
+            }
+        }
+        return true;
+    }
+
+    // 20%, 0.8, 50MB/min, 1K/s
+    bool ParseThreshold(const std::string& token, double& out) {
+        char* end = nullptr;
+        double v = std::strtod(token.c_str(), &end);
+        if (end == token.c_str()) return false;
+        std::string unit(end);
+        std::string per;
+        size_t slash = unit.find('/');
+        if (slash != std::string::npos) {
+            per = unit.substr(slash + 1);
+            unit.erase(slash);
+        }
+        if (unit == "%") v /= 100.0;
+        else if (unit == "K" || unit == "KB") v *= 1024.0;
+        else if (unit == "M" || unit == "MB") v *= 1024.0 * 1024.0;
+        else if (unit == "G" || unit == "GB") v *= 1024.0 * 1024.0 * 1024.0;
+        else if (!unit.empty()) return false;
+        if (per == "min") v /= 60.0;
+        else if (per == "h") v /= 3600.0;
+        else if (!per.empty() && per != "s") return false;
+        out = v;
+        return true;
+    }
+
+    // 500ms, 5s, 2m, 1h, or plain seconds
+    bool ParseDuration(const std::string& token, double& out) {
+        char* end = nullptr;
+        double v = std::strtod(token.c_str(), &end);
+        if (end == token.c_str() || v < 0) return false;
+        std::string unit(end);
+        if (unit == "ms") v /= 1000.0;
+        else if (unit == "m") v *= 60.0;
+        else if (unit == "h") v *= 3600.0;
+        else if (!unit.empty() && unit != "s") return false;
+        out = v;
+        return true;
+    }
+
+    std::string Basename(const std::string& command) {
+        std::string exe = command.substr(0, command.find(' '));
+        size_t slash = exe.rfind('/');
+        return slash == std::string::npos ? exe : exe.substr(slash + 1);
+    }
+
+    double Now() {
+        using namespace std::chrono;
+        return duration<double>(steady_clock::now().time_since_epoch()).count();
+    }
+}; // namespace
+
+void AlertEngine::Window::Push(double t, double v, double span) {
+    if (origin_ < 0) origin_ = t;
+    const double x = t - origin_;  // keeps the regression sums small
+    if (last_push_ < 0 || t - last_push_ >= span / kSamples) {
+        last_push_ = t;
+        if (count_ == kSamples) PopFront();
+        const int slot = (head_ + count_++) % kSamples;
+        samples_[slot] = {x, v};
+        sum_t_ += x;
+        sum_v_ += v;
+        sum_tt_ += x * x;
+        sum_tv_ += x * v;
+        while (min_.count > 0 && samples_[min_.Back()].v >= v) min_.PopBack();
+        min_.PushBack(slot);
+        while (max_.count > 0 && samples_[max_.Back()].v <= v) max_.PopBack();
+        max_.PushBack(slot);
+    }
+    while (count_ > 1 && samples_[head_].t < x - span) PopFront();
+}
+
+void AlertEngine::Window::PopFront() {
+    const Sample old = samples_[head_];
+    sum_t_ -= old.t;
+    sum_v_ -= old.v;
+    sum_tt_ -= old.t * old.t;
+    sum_tv_ -= old.t * old.v;
+    // every queued slot is inside the window, so the oldest one can only be at the front
+    if (min_.Front() == head_) min_.PopFront();
+    if (max_.Front() == head_) max_.PopFront();
+    head_ = (head_ + 1) % kSamples;
+    --count_;
+}
+
+double AlertEngine::Window::Min() const { return min_.count == 0 ? 0.0 : samples_[min_.Front()].v; }
+double AlertEngine::Window::Max() const { return max_.count == 0 ? 0.0 : samples_[max_.Front()].v; }
+double AlertEngine::Window::Avg() const { return count_ == 0 ? 0.0 : sum_v_ / count_; }
+
+double AlertEngine::Window::Slope() const {
+    const double n = static_cast<double>(count_);
+    const double denom = n * sum_tt_ - sum_t_ * sum_t_;
+    if (n < 2 || std::fabs(denom) < 1e-9) return 0.0;
+    return (n * sum_tv_ - sum_t_ * sum_v_) / denom;
+}
+
+bool AlertEngine::Load(const std::string& path, std::string& error) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error = path + ": cannot open";
+        return false;
+    }
+    std::string line;
+    std::vector<std::string> tok;
+    int line_no = 0;
+    while (std::getline(file, line)) {
+        ++line_no;
+        auto fail = [&](const std::string& why) {
+            error = path + ":" + std::to_string(line_no) + ": " + why;
+            return false;
+        };
+        if (!Tokenize(line, tok)) return fail("unterminated quote");
+        if (tok.empty()) continue;
+        size_t i = 0;
+        auto next = [&]() -> const std::string& {
+            static const std::string kEnd;
+            return i < tok.size() ? tok[i++] : kEnd;
+        };
+
+        Plan plan;
+        plan.name = next();
+        if (next() != ":") return fail("expected 'name:' at the start of the rule");
+
+        std::string metric = next();
+        const std::pair<const char*, Agg> aggs[] = {
+            {"min", Agg::kMin}, {"max", Agg::kMax}, {"avg", Agg::kAvg}, {"slope", Agg::kSlope}};
+        for (const auto& agg : aggs) {
+            if (metric != agg.first) continue;
+            plan.agg = agg.second;
+            if (next() != "(") return fail("expected '(' after " + metric);
+            metric = next();
+            if (next() != "," || !ParseDuration(next(), plan.window) || plan.window <= 0) {
+                return fail("expected ', window)' like ', 30s)'");
+            }
+            if (next() != ")") return fail("expected ')'");
+        }
+        bool known = false;
+        for (const MetricName& m : kMetrics) {
+            if (metric != m.name) continue;
+            plan.scope = m.scope;
+            plan.metric = m.metric;
+            known = true;
+        }
+        if (!known) return fail("unknown metric '" + metric + "'");
+
+        const std::string op = next();
+        if (op != ">" && op != "<") return fail("expected '>' or '<' after the metric");
+        plan.above = op == ">";
+        if (!ParseThreshold(next(), plan.threshold)) return fail("bad threshold");
+        plan.clear = plan.threshold;
+
+        while (i < tok.size()) {
+            const std::string clause = next();
+            const std::string arg = next();
+            if (clause == "for") {
+                if (!ParseDuration(arg, plan.hold)) return fail("bad 'for' duration");
+            } else if (clause == "clear") {
+                if (!ParseThreshold(arg, plan.clear)) return fail("bad 'clear' threshold");
+            } else if (clause == "every") {
+                if (!ParseDuration(arg, plan.every)) return fail("bad 'every' duration");
+            } else if (clause == "log" && !arg.empty()) {
+                plan.log_path = arg;
+            } else if (clause == "exec" && arg.size() >= 2 && arg.front() == '"') {
+                plan.command = arg.substr(1, arg.size() - 2);
+            } else {
+                return fail("unexpected '" + clause + "'");
+            }
+        }
+        // a clear level past the threshold would end the alert on the sample that fires it
+        if (plan.above ? plan.clear > plan.threshold : plan.clear < plan.threshold) {
+            return fail(std::string("'clear' must be ") + (plan.above ? "at or below" : "at or above") + " the threshold");
+        }
+        plans_.push_back(std::move(plan));
+    }
+    return true;
+}
+
+bool AlertEngine::Empty() const { return plans_.empty(); }
+const std::vector<AlertEngine::Alert>& AlertEngine::Firing() const { return firing_; }
+const std::unordered_set<int>& AlertEngine::FiringPids() const { return firing_pids_; }
+
+bool AlertEngine::NeedsCoreBreakdown() const {
+    for (const Plan& plan : plans_) {
+        if (plan.scope == Scope::kCore && plan.metric != Metric::kCoreUtil) return true;
+    }
+    return false;
+}
+
+void AlertEngine::Evaluate(const Snapshot& snap) {
+    if (plans_.empty()) return;
+    const double now = Now();
+    ++epoch_;
+    firing_.clear();
+    firing_pids_.clear();
+
+    for (Plan& plan : plans_) {
+        switch (plan.scope) {
+            case Scope::kSystem: {
+                double v = plan.metric == Metric::kCpu ? snap.total_cpu
+                         : plan.metric == Metric::kMem ? snap.mem_used : snap.tcp_retrans;
+                Step(plan, 0, "", v, now);
+                break;
+            }
+            case Scope::kCore: {
+                const std::vector<float>& series = plan.metric == Metric::kCoreUser ? snap.core_user
+                                                 : plan.metric == Metric::kCoreSystem ? snap.core_system
+                                                 : plan.metric == Metric::kCoreIOwait ? snap.core_iowait
+                                                 : plan.metric == Metric::kCoreSteal ? snap.core_steal : snap.cores;
+                // keyed by cpu number, an index shifts when a cpu goes offline
+                for (size_t i = 0; i < series.size(); ++i) {
+                    const int id = i < snap.core_ids.size() ? snap.core_ids[i] : static_cast<int>(i);
+                    Step(plan, id, "cpu", series[i], now);
+                }
+                break;
+            }
+            case Scope::kNet: {
+                for (size_t i = 0; i < snap.interfaces.size(); ++i) {
+                    const Network::Interface& iface = snap.interfaces[i];
+                    if (!iface.active) continue;
+                    double v = plan.metric == Metric::kNetRx ? iface.rx_bytes
+                             : plan.metric == Metric::kNetTx ? iface.tx_bytes
+                             : plan.metric == Metric::kNetErrors ? iface.errors : iface.drops;
+                    // a slot reused by another interface must not inherit the old window
+                    long long key = (static_cast<long long>(i) << 32) | iface.generation;
+                    Step(plan, key, iface.name, v, now);
+                }
+                break;
+            }
+            case Scope::kProcess: {
+                for (const ProcessRow& row : snap.procs) {
+                    double v = plan.metric == Metric::kProcCpu ? row.cpu : static_cast<double>(row.ram_kb) * 1024.0;
+                    Step(plan, row.pid, row.command, v, now);
+                }
+                break;
+            }
+        }
+
+        // forget cores, interfaces and processes that are gone
+        for (auto it = plan.entities.begin(); it != plan.entities.end();) {
+            if (it->second.seen != epoch_) it = plan.entities.erase(it);
+            else ++it;
+        }
+    }
+    Reap();
+}
+
+void AlertEngine::Step(Plan& plan, long long key, const std::string& name, double value, double now) {
+    EntityState& st = plan.entities[key];
+    st.seen = epoch_;
+    double v = value;
+    if (plan.agg != Agg::kValue) {
+        if (!st.window) st.window = std::make_unique<Window>();
+        Window& window = *st.window;
+        window.Push(now, value, plan.window);
+        v = plan.agg == Agg::kMin ? window.Min()
+          : plan.agg == Agg::kMax ? window.Max()
+          : plan.agg == Agg::kAvg ? window.Avg() : window.Slope();
+    }
+
+    bool fired = false;
+    if (!st.firing) {
+        const bool hit = plan.above ? v > plan.threshold : v < plan.threshold;
+        if (!hit) {
+            st.pending_since = -1;
+            return;
+        }
+        if (st.pending_since < 0) st.pending_since = now;
+        if (now - st.pending_since < plan.hold) return;
+        st.firing = fired = true;
+    } else if (plan.above ? v < plan.clear : v > plan.clear) {
+        // hysteresis: only crossing back over `clear` ends the alert
+        st.firing = false;
+        st.pending_since = -1;
+        return;
+    }
+
+    // labels are only built for the few entities that are actually firing
+    Alert alert;
+    alert.rule = plan.name;
+    alert.value = v;
+    if (plan.scope == Scope::kCore) {
+        alert.entity = name + std::to_string(key);
+    } else if (plan.scope == Scope::kProcess) {
+        alert.pid = static_cast<int>(key);
+        alert.entity = std::to_string(key) + " " + Basename(name);
+    } else {
+        alert.entity = name;
+    }
+    if (fired) Act(plan, alert.entity, v, now);
+    if (alert.pid) firing_pids_.insert(alert.pid);
+    firing_.push_back(std::move(alert));
+}
+
+void AlertEngine::Act(Plan& plan, const std::string& entity, double value, double now) {
+    if (plan.log_path.empty() && plan.command.empty()) return;
+    if (now - plan.last_action < plan.every) return;
+    plan.last_action = now;
+
+    if (!plan.log_path.empty()) {
+        std::ofstream log(plan.log_path, std::ios::app);
+        char stamp[32];
+        std::time_t t = std::time(nullptr);
+        std::tm local;
+        localtime_r(&t, &local);
+        std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", &local);
+        log << stamp << " " << plan.name << " " << (entity.empty() ? "-" : entity) << " " << value << "\n";
+    }
+    if (!plan.command.empty()) {
+        std::vector<std::string> env;
+        for (char** e = environ; *e; ++e) env.emplace_back(*e);
+        env.push_back("MTOP_RULE=" + plan.name);
+        env.push_back("MTOP_ENTITY=" + entity);
+        env.push_back("MTOP_VALUE=" + std::to_string(value));
+        std::vector<char*> envp;
+        for (auto& e : env) envp.push_back(&e[0]);
+        envp.push_back(nullptr);
+        char sh[] = "sh", dash_c[] = "-c";
+        char* argv[] = {sh, dash_c, &plan.command[0], nullptr};
+        pid_t child;
+        if (posix_spawn(&child, "/bin/sh", nullptr, nullptr, argv, envp.data()) == 0) ++children_;
+    }
+}
+
+void AlertEngine::Reap() {
+    while (children_ > 0 && waitpid(-1, nullptr, WNOHANG) > 0) --children_;
+}
@@ -0,0 +1,113 @@
+#include "../include/core_stats.hpp"
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+    using LinuxParser::CpuTimesSoA;
+
+    // deltas of one column, unsigned wrap-around keeps them exact across 32 bit overflow
+    struct Column {
+        const uint32_t* __restrict prev;
+        const uint32_t* __restrict curr;
+    };
+
+    Column Col(const CpuTimesSoA& prev, const CpuTimesSoA& curr, int state) {
+        return {prev.column[state].data(), curr.column[state].data()};
+    }
+
+    inline float Share(uint32_t part, float total) {
+        // a counter that went backwards (cpu hotplug) ends up negative and is clamped away
+        return std::min(1.f, std::max(0.f, static_cast<float>(static_cast<int32_t>(part)) / total));
+    }
+
+    template <bool kBreakdown>
+    void UtilKernel(size_t n, const CpuTimesSoA& prev, const CpuTimesSoA& curr,
+                    float* __restrict util, float* __restrict user, float* __restrict system,
+                    float* __restrict iowait, float* __restrict steal) {
+        const Column c_user = Col(prev, curr, LinuxParser::kUser_);
+        const Column c_nice = Col(prev, curr, LinuxParser::kNice_);
+        const Column c_system = Col(prev, curr, LinuxParser::kSystem_);
+        const Column c_idle = Col(prev, curr, LinuxParser::kIdle_);
+        const Column c_iowait = Col(prev, curr, LinuxParser::kIOwait_);
+        const Column c_irq = Col(prev, curr, LinuxParser::kIRQ_);
+        const Column c_softirq = Col(prev, curr, LinuxParser::kSoftIRQ_);
+        const Column c_steal = Col(prev, curr, LinuxParser::kSteal_);
+        const Column c_guest = Col(prev, curr, LinuxParser::kGuest_);
+        const Column c_guest_nice = Col(prev, curr, LinuxParser::kGuestNice_);
+
+        for (size_t i = 0; i < n; ++i) {
+            uint32_t d_user = c_user.curr[i] - c_user.prev[i];
+            uint32_t d_nice = c_nice.curr[i] - c_nice.prev[i];
+            uint32_t d_system = c_system.curr[i] - c_system.prev[i];
+            uint32_t d_iowait = c_iowait.curr[i] - c_iowait.prev[i];
+            uint32_t d_irq = c_irq.curr[i] - c_irq.prev[i];
+            uint32_t d_softirq = c_softirq.curr[i] - c_softirq.prev[i];
+            uint32_t d_steal = c_steal.curr[i] - c_steal.prev[i];
+            uint32_t idle = (c_idle.curr[i] - c_idle.prev[i]) + d_iowait;
+            // guest and guest_nice are already part of user and nice
+            uint32_t busy = d_user + d_nice + d_system + d_irq + d_softirq + d_steal;
+            float total = std::max(1.f, static_cast<float>(static_cast<int32_t>(idle + busy)));
+
+            util[i] = Share(busy, total);
+            if (kBreakdown) {
+                uint32_t d_guest = (c_guest.curr[i] - c_guest.prev[i]) + (c_guest_nice.curr[i] - c_guest_nice.prev[i]);
+                user[i] = Share(d_user + d_nice - d_guest, total);
+                system[i] = Share(d_system + d_irq + d_softirq, total);
+                iowait[i] = Share(d_iowait, total);
+                steal[i] = Share(d_steal, total);
+            }
+        }
+    }
+}; // namespace
+
+CoreStats::CoreStats(bool breakdown) : breakdown_(breakdown) {
+    fd_ = open((LinuxParser::kProcDirectory + LinuxParser::kStatFilename).c_str(), O_RDONLY | O_CLOEXEC);
+}
+
+CoreStats::~CoreStats() {
+    if (fd_ >= 0) close(fd_);
+}
+
+size_t CoreStats::Count() const { return util_.size(); }
+const std::vector<float>& CoreStats::Utilization() const { return util_; }
+const std::vector<int>& CoreStats::CpuIds() const { return times_[curr_].cpu; }
+const std::vector<float>& CoreStats::User() const { return user_; }
+const std::vector<float>& CoreStats::System() const { return system_; }
+const std::vector<float>& CoreStats::IOwait() const { return iowait_; }
+const std::vector<float>& CoreStats::Steal() const { return steal_; }
+
+bool CoreStats::Update() {
+    if (!LinuxParser::ReadFd(fd_, buffer_)) return false;
+    const int next = curr_ ^ 1;
+    if (!LinuxParser::ParseCpuTimes(buffer_, times_[next])) return false;
+
+    const CpuTimesSoA& prev = times_[curr_];
+    const CpuTimesSoA& curr = times_[next];
+    const size_t n = curr.Size();
+    // the very first sample, or cpus came and went: no usable baseline this round
+    const bool baseline = primed_ && prev.Size() == n;
+
+    util_.resize(n);
+    if (breakdown_) {
+        user_.resize(n);
+        system_.resize(n);
+        iowait_.resize(n);
+        steal_.resize(n);
+    }
+    if (!baseline) {
+        std::fill(util_.begin(), util_.end(), 0.f);
+        std::fill(user_.begin(), user_.end(), 0.f);
+        std::fill(system_.begin(), system_.end(), 0.f);
+        std::fill(iowait_.begin(), iowait_.end(), 0.f);
+        std::fill(steal_.begin(), steal_.end(), 0.f);
+    } else if (breakdown_) {
+        UtilKernel<true>(n, prev, curr, util_.data(), user_.data(), system_.data(), iowait_.data(), steal_.data());
+    } else {
+        UtilKernel<false>(n, prev, curr, util_.data(), nullptr, nullptr, nullptr, nullptr);
+    }
+
+    curr_ = next;
+    primed_ = true;
+    return true;
+}
@@ -0,0 +1,170 @@
+#include "../include/heatmap.hpp"
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <string>
+
+#include <ftxui/dom/node.hpp>
+#include <ftxui/screen/color.hpp>
+#include <ftxui/screen/screen.hpp>
+#include <ftxui/screen/terminal.hpp>
+
+namespace {
+    using namespace ftxui;
+
+    constexpr int kGutter = 4;     // room for a "n12" group label and a space in front of each band
+    constexpr int kMinBand = 8;    // narrowest band (time columns) before cores get merged
+    constexpr int kLevels = 16;
+
+    // dark blue (idle) -> green -> yellow -> red (saturated)
+    const std::array<Color, kLevels>& Palette() {
+        static const std::array<Color, kLevels> palette = [] {
+            struct Stop { float at; int r, g, b; };
+            const Stop stops[] = {{0.f, 20, 30, 70}, {0.5f, 40, 170, 70}, {0.75f, 230, 200, 40}, {1.f, 220, 40, 40}};
+            std::array<Color, kLevels> out;
+            for (int i = 0; i < kLevels; ++i) {
+                float t = static_cast<float>(i) / (kLevels - 1);
+                int s = 0;
+                while (s < 2 && t > stops[s + 1].at) ++s;
+                float f = (t - stops[s].at) / (stops[s + 1].at - stops[s].at);
+                auto mix = [f](int a, int b) { return static_cast<uint8_t>(a + (b - a) * f); };
+                out[i] = Color::RGB(mix(stops[s].r, stops[s + 1].r), mix(stops[s].g, stops[s + 1].g),
+                                    mix(stops[s].b, stops[s + 1].b));
+            }
+            return out;
+        }();
+        return palette;
+    }
+
+    // one half-cell row: `count` cores starting at order[first], or a blank spacer when count == 0
+    struct Lane {
+        int first{0};
+        int count{0};
+        int label{-1};
+    };
+
+    Color Shade(float value) {
+        if (value < 0.f) return Color::Black;
+        int level = static_cast<int>(std::clamp(value, 0.f, 1.f) * (kLevels - 1) + 0.5f);
+        return Palette()[level];
+    }
+
+    class HeatmapNode : public Node {
+        public:
+            // the layout is fixed here, for the area the heatmap got on the previous frame, and only
+            // the values on screen are copied: one per lane and column, merged cores already folded in.
+            // Render() then runs after the caller dropped its lock and costs one pass over the cells
+            HeatmapNode(const std::vector<std::deque<float>>& history, const std::vector<int>& order,
+                        const std::vector<int>& group, std::shared_ptr<Heatmap::Area> area)
+                : area_(std::move(area)) {
+                const int width = area_->width > 0 ? area_->width : Terminal::Size().dimx;
+                const int height = area_->height > 0 ? area_->height : Terminal::Size().dimy;
+                const int cores = static_cast<int>(order.size());
+                height_ = std::max(1, height);
+                if (width < kGutter + 1 || cores == 0) return;
+
+                // pick the smallest merge factor whose bands still get kMinBand columns
+                const int max_bands = std::max(1, width / (kGutter + kMinBand));
+                int merge = std::max(1, (cores + 2 * height_ * max_bands - 1) / (2 * height_ * max_bands));
+                for (;; ++merge) {
+                    BuildLanes(group, cores, merge);
+                    int rows = (static_cast<int>(lanes_.size()) + 1) / 2;
+                    bands_ = (rows + height_ - 1) / height_;
+                    if (bands_ <= max_bands || merge >= cores) break;
+                }
+                columns_ = std::max(1, width / bands_ - kGutter);
+
+                // newest sample in the rightmost column, -1 where there is none
+                values_.assign(lanes_.size() * columns_, -1.f);
+                for (size_t l = 0; l < lanes_.size(); ++l) {
+                    float* row = &values_[l * columns_];
+                    for (int k = lanes_[l].first; k < lanes_[l].first + lanes_[l].count; ++k) {
+                        const auto& hist = history[order[k]];
+                        const int n = std::min(columns_, static_cast<int>(hist.size()));
+                        for (int c = 0; c < n; ++c) {
+                            float& v = row[columns_ - n + c];
+                            v = std::max(v, hist[hist.size() - n + c]);
+                        }
+                    }
+                }
+            }
+
+            void ComputeRequirement() override {
+                requirement_.min_x = kGutter + kMinBand;
+                requirement_.min_y = 2;
+                requirement_.flex_grow_x = 1;
+                requirement_.flex_grow_y = 1;
+                requirement_.flex_shrink_x = 1;
+                requirement_.flex_shrink_y = 1;
+            }
+
+            void Render(Screen& screen) override {
+                // the next frame is laid out for the area we got now
+                area_->width = box_.x_max - box_.x_min + 1;
+                area_->height = box_.y_max - box_.y_min + 1;
+
+                for (int b = 0; b < bands_; ++b) {
+                    const int x0 = box_.x_min + b * (columns_ + kGutter);
+                    if (x0 > box_.x_max) break;
+                    for (int r = 0; r < height_ && box_.y_min + r <= box_.y_max; ++r) {
+                        const int y = box_.y_min + r;
+                        const size_t top = static_cast<size_t>((b * height_ + r) * 2);
+                        if (top >= lanes_.size()) break;
+                        const bool lower = top + 1 < lanes_.size();
+
+                        int label = lanes_[top].label >= 0 ? lanes_[top].label : (lower ? lanes_[top + 1].label : -1);
+                        if (label >= 0) {
+                            std::string tag = "n" + std::to_string(label);
+                            for (int i = 0; i < kGutter - 1 && i < static_cast<int>(tag.size()) && x0 + i <= box_.x_max; ++i) {
+                                screen.PixelAt(x0 + i, y).character = tag[i];
+                            }
+                        }
+                        const float* upper_values = &values_[top * columns_];
+                        const float* lower_values = lower ? &values_[(top + 1) * columns_] : nullptr;
+                        for (int c = 0; c < columns_ && x0 + kGutter + c <= box_.x_max; ++c) {
+                            Pixel& pixel = screen.PixelAt(x0 + kGutter + c, y);
+                            pixel.character = "▀";
+                            pixel.foreground_color = Shade(upper_values[c]);
+                            pixel.background_color = lower_values ? Shade(lower_values[c]) : Color::Black;
+                        }
+                    }
+                }
+            }
+
+        private:
+            void BuildLanes(const std::vector<int>& group, int cores, int merge) {
+                lanes_.clear();
+                int prev_group = -1;
+                int in_group = 0;
+                for (int i = 0; i < cores; ++i) {
+                    int g = i < static_cast<int>(group.size()) ? group[i] : 0;
+                    if (i == 0 || g != prev_group) {
+                        // every group starts on the upper half of a fresh row
+                        if (lanes_.size() % 2 == 1) lanes_.push_back({});
+                        lanes_.push_back({i, 0, g});
+                        prev_group = g;
+                        in_group = 0;
+                    } else if (in_group == merge) {
+                        lanes_.push_back({i, 0, -1});
+                        in_group = 0;
+                    }
+                    ++lanes_.back().count;
+                    ++in_group;
+                }
+            }
+
+            std::shared_ptr<Heatmap::Area> area_;
+            int height_{1};
+            int bands_{1};
+            int columns_{0};              // time columns per band
+            std::vector<Lane> lanes_;
+            std::vector<float> values_;   // lanes_ x columns_, oldest first
+    };
+}; // namespace
+
+ftxui::Element Heatmap::Render(const std::vector<std::deque<float>>& history,
+                               const std::vector<int>& order,
+                               const std::vector<int>& group,
+                               std::shared_ptr<Area> area) {
+    return std::make_shared<HeatmapNode>(history, order, group, std::move(area));
+}
@@ -1,9 +1,13 @@
 #include "../include/linux_parser.hpp"
 #include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
 #include <dirent.h>
 #include <fstream>
 #include <ios>
 #include <limits>
+#include <fcntl.h>
 #include <sstream>
 #include <string>
 #include <unistd.h>
@@ -45,6 +49,22 @@ namespace {
             return 0;
         }
     }
+
+    // hand rolled field scanning for the files we re-read every cycle, no streams involved
+    const char* SkipSpaces(const char* p, const char* end) {
+        while (p < end && (*p == ' ' || *p == '\t')) ++p;
+        return p;
+    }
+
+    unsigned long long NextULL(const char*& p, const char* end) {
+        p = SkipSpaces(p, end);
+        unsigned long long v = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            v = v * 10 + static_cast<unsigned long long>(*p - '0');
+            ++p;
+        }
+        return v;
+    }
 }; // namespace 
 
 float LinuxParser::MemoryUtilization() {
@@ -286,7 +306,10 @@ std::string LinuxParser::Uid(int pid) {
 }
 
 std::string LinuxParser::User(int pid) {
-    std::string uid = Uid(pid);
+    return UserByUid(Uid(pid));
+}
+
+std::string LinuxParser::UserByUid(const std::string& uid) {
     if (uid.empty()) return {};
     std::ifstream file(kPasswordPath);
     if (!file.is_open()) return {};
@@ -324,33 +347,203 @@ long int LinuxParser::UpTime(int pid) {
     return seconds;
 }
 
-bool LinuxParser::ReadCpuTimesAll(std::vector<CpuTimes>& out) {
-    std::ifstream file(kProcDirectory + kStatFilename);
-    if (!file.is_open()) return false;
-    out.clear();
-    std::string line;
-    while (std::getline(file, line)) {
-        if (line.rfind("cpu", 0) != 0) break;
-        std::istringstream ss(line);
-        std::string cpu_label;
-        CpuTimes time;
-        ss >> cpu_label;
-        ss >> time.user >> time.nice >> time.system >> time.idle >> time.iowait >> time.irq >> time.softirq >> time.steal;
-        out.push_back(time);
+bool LinuxParser::ParseCpuTimes(const std::string& content, CpuTimesSoA& out) {
+    size_t count = 0;
+    const char* p = content.data();
+    const char* end = p + content.size();
+    while (p + 3 <= end && p[0] == 'c' && p[1] == 'p' && p[2] == 'u') {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (!eol) eol = end;
+        p += 3;
+        if (count == out.Size()) out.Resize(count + 1);
+        // offline cpus have no line, so the label is the only reliable cpu id
+        out.cpu[count] = (p < eol && *p >= '0' && *p <= '9') ? static_cast<int>(NextULL(p, eol)) : -1;
+        for (auto& col : out.column) col[count] = static_cast<uint32_t>(NextULL(p, eol));
+        ++count;
+        p = eol + 1;
+    }
+    if (count != out.Size()) out.Resize(count);
+    return count > 0;
+}
+
+std::vector<int> LinuxParser::CpuNodes() {
+    std::vector<int> nodes;
+    DIR* directory = opendir(kNodeDirectory.c_str());
+    if (!directory) return nodes;
+    struct dirent* file;
+    while ((file = readdir(directory)) != nullptr) {
+        std::string name(file->d_name);
+        if (name.size() < 5 || name.compare(0, 4, "node") != 0) continue;
+        if (!std::all_of(name.begin() + 4, name.end(), ::isdigit)) continue;
+        int node = std::stoi(name.substr(4));
+        std::string cpulist;
+        if (!ReadFile(kNodeDirectory + name + kCpulistFilename, cpulist)) continue;
+        // ranges like "0-3,8-11"
+        const char* p = cpulist.data();
+        const char* end = p + cpulist.size();
+        while (p < end && *p >= '0' && *p <= '9') {
+            int first = static_cast<int>(NextULL(p, end));
+            int last = first;
+            if (p < end && *p == '-') last = static_cast<int>(NextULL(++p, end));
+            if (last >= static_cast<int>(nodes.size())) nodes.resize(last + 1, 0);
+            for (int cpu = first; cpu <= last; ++cpu) nodes[cpu] = node;
+            if (p < end && *p == ',') ++p;
+        }
+    }
+    closedir(directory);
+    return nodes;
+}
+
+bool LinuxParser::ReadFd(int fd, std::string& buf) {
+    if (fd < 0) return false;
+    if (buf.size() < 4096) buf.resize(4096);
+    else buf.resize(buf.capacity());
+    size_t used = 0;
+    while (true) {
+        ssize_t n = pread(fd, &buf[used], buf.size() - used, static_cast<off_t>(used));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            buf.clear();
+            return false;
+        }
+        // seq_files hand out about a page per call, only a zero read is the end
+        if (n == 0) break;
+        used += static_cast<size_t>(n);
+        if (used == buf.size()) buf.resize(buf.size() * 2);
+    }
+    buf.resize(used);
+    return true;
+}
+
+bool LinuxParser::ParseNetDev(const std::string& content, std::vector<NetDevCounters>& out) {
+    /*
+        Inter-|   Receive                                                |  Transmit
+         face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed
+            lo:  291602     123    0    0    0     0          0         0   291602     123    0    0    0     0       0          0
+    */
+    size_t count = 0;
+    const char* p = content.data();
+    const char* end = p + content.size();
+    int line_no = 0;
+    while (p < end) {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (!eol) eol = end;
+        if (line_no++ >= 2) {
+            const char* colon = static_cast<const char*>(std::memchr(p, ':', eol - p));
+            if (colon) {
+                const char* name = SkipSpaces(p, colon);
+                // reuse the slot (and its name buffer) from the previous call
+                if (count == out.size()) out.emplace_back();
+                NetDevCounters& c = out[count++];
+                c.name.assign(name, colon - name);
+                const char* f = colon + 1;
+                c.rx_bytes = NextULL(f, eol);
+                c.rx_packets = NextULL(f, eol);
+                c.rx_errs = NextULL(f, eol);
+                c.rx_drop = NextULL(f, eol);
+                for (int skip = 0; skip < 4; ++skip) NextULL(f, eol);  // fifo frame compressed multicast
+                c.tx_bytes = NextULL(f, eol);
+                c.tx_packets = NextULL(f, eol);
+                c.tx_errs = NextULL(f, eol);
+                c.tx_drop = NextULL(f, eol);
+            }
+        }
+        p = eol + 1;
     }
-    return !out.empty();
+    out.resize(count);
+    return count > 0;
 }
 
-float LinuxParser::UtilFromData(const CpuTimes &prev, const CpuTimes &curr) {
-    long prev_idle = prev.idle + prev.iowait;
-    long idle = curr.idle + curr.iowait;
-    long prev_non = prev.user + prev.nice + prev.system + prev.irq + prev.softirq + prev.steal;
-    long non = curr.user + curr.nice + curr.system + curr.irq + curr.softirq + curr.steal;
-    long prev_total = prev_idle + prev_non;
-    long total = idle + non;
-    // d for deltas :) 
-    long totald = total - prev_total;
-    long idled = idle - prev_idle;
-    if (totald <= 0) return 0.f;
-    return std::max(0.f, std::min(1.f, (totald - idled) / static_cast<float>(totald)));
-}
\ No newline at end of file
+bool LinuxParser::ParseTcpRetransSegs(const std::string& content, unsigned long long& out) {
+    // two "Tcp:" lines, the first holds the column names and the second the values
+    size_t header = content.find("\nTcp:");
+    if (header == std::string::npos) return false;
+    size_t values = content.find("\nTcp:", header + 1);
+    if (values == std::string::npos) return false;
+    const char* p = content.data() + header + 5;
+    const char* eol = content.data() + content.find('\n', header + 1);
+    static const char kName[] = "RetransSegs";
+    const size_t name_size = sizeof(kName) - 1;
+    int column = 0;
+    for (;; ++column) {
+        p = SkipSpaces(p, eol);
+        if (p >= eol) return false;
+        const char* name = p;
+        while (p < eol && *p != ' ' && *p != '\t') ++p;
+        if (static_cast<size_t>(p - name) == name_size && std::memcmp(name, kName, name_size) == 0) break;
+    }
+
+    p = content.data() + values + 5;
+    const char* end = content.data() + content.size();
+    for (int i = 0; i < column; ++i) {
+        p = SkipSpaces(p, end);
+        if (p < end && *p == '-') ++p;  // MaxConn is -1
+        NextULL(p, end);
+    }
+    out = NextULL(p, end);
+    return true;
+}
+
+bool LinuxParser::ReadPath(const char* path, std::string& buf) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    bool ok = ReadFd(fd, buf);
+    close(fd);
+    return ok;
+}
+
+bool LinuxParser::ParseProcStat(const std::string& content, ProcStat& out) {
+    // comm may hold spaces and parentheses itself, it ends at the last ')'
+    size_t open_paren = content.find('(');
+    size_t close_paren = content.rfind(')');
+    if (open_paren == std::string::npos || close_paren == std::string::npos || close_paren < open_paren) return false;
+    out.comm.assign(content, open_paren + 1, close_paren - open_paren - 1);
+
+    const char* p = content.data() + close_paren + 1;
+    const char* end = content.data() + content.size();
+    int field = 2;
+    while (p < end) {
+        p = SkipSpaces(p, end);
+        const char* token = p;
+        while (p < end && *p != ' ' && *p != '\n') ++p;
+        if (p == token) break;
+        ++field;
+        switch (field) {
+            case 3: out.state = *token; break;
+            case 14: out.utime = std::strtol(token, nullptr, 10); break;
+            case 15: out.stime = std::strtol(token, nullptr, 10); break;
+            case 16: out.cutime = std::strtol(token, nullptr, 10); break;
+            case 17: out.cstime = std::strtol(token, nullptr, 10); break;
+            case 22: out.starttime = std::strtoll(token, nullptr, 10); break;
+            case 24: out.rss = std::strtol(token, nullptr, 10); break;
+            case 39: out.processor = static_cast<int>(std::strtol(token, nullptr, 10)); return true;
+            default: break;
+        }
+    }
+    return field >= 24;
+}
+
+bool LinuxParser::ParseProcIo(const std::string& content, unsigned long long& read_bytes, unsigned long long& write_bytes) {
+    // read_bytes / write_bytes are what actually hit the storage layer
+    size_t r = content.find("\nread_bytes:");
+    size_t w = content.find("\nwrite_bytes:");
+    if (r == std::string::npos || w == std::string::npos) return false;
+    const char* end = content.data() + content.size();
+    const char* p = content.data() + r + 12;
+    read_bytes = NextULL(p, end);
+    p = content.data() + w + 13;
+    write_bytes = NextULL(p, end);
+    return true;
+}
+
+bool LinuxParser::Tids(int pid, std::vector<int>& out) {
+    out.clear();
+    DIR* directory = opendir((kProcDirectory + std::to_string(pid) + kTaskDirectory).c_str());
+    if (!directory) return false;
+    struct dirent* file;
+    while ((file = readdir(directory)) != nullptr) {
+        if (file->d_name[0] >= '0' && file->d_name[0] <= '9') out.push_back(std::atoi(file->d_name));
+    }
+    closedir(directory);
+    return true;
+}
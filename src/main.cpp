@@ -7,129 +7,376 @@
 #include <ftxui/dom/node.hpp>
 #include <ftxui/screen/color.hpp>
 #include <ftxui/dom/linear_gradient.hpp> 
+#include <ftxui/screen/terminal.hpp>
 #include "../include/utils.hpp"
-#include "../include/system.hpp"
-#include "../include/linux_parser.hpp"
+#include "../include/heatmap.hpp"
+#include "../include/sampler.hpp"
+#include "../include/snapshot.hpp"
+#include "../include/snapshot_feed.hpp"
+#include "../include/shm_export.hpp"
+#include "../include/metrics_exporter.hpp"
+#include "../include/alerts.hpp"
+#include "../include/process_view.hpp"
+#include "../include/task_table.hpp"
 
 #include <array>
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
 #include <mutex>
 #include <string>
 #include <iostream>
 #include <deque>
+#include <thread>
 #include <vector>
 #include <algorithm>
 #include <cmath>
 #include <optional>
 #include <unordered_map>
+#include <unordered_set>
 #include <functional>
+#include <limits>
 
 struct AppState {
-    float total_cpu{0.f};
-    float mem_used{0.f};
-    long uptime{0};
-    std::vector<std::array<std::string, 5>> procs;
+    Snapshot snap;
+    std::string feed_status;  // --attach only
+    std::vector<AlertEngine::Alert> alerts;
+    std::unordered_set<int> alert_pids;
+
+    // process table: the order the sampler thread built (indices into snap.procs) and the sort and
+    // filter it was built with. Key presses and the '/' prompt only queue requests for its next cycle
+    std::vector<int> rows;
+    ProcessView::Key sort_key{ProcessView::Key::kCpu};
+    bool sort_descending{true};
+    std::string filter;
+    std::vector<ProcessView::Key> sort_requests;
+    bool filter_requested{false};
+    bool filtering{false};
+    std::string filter_input;
+    std::string filter_error;
+    // selected row (by pid so it survives re-sorts), first row built, and the processes expanded into threads
+    int selected_pid{-1};
+    size_t scroll{0};
+    std::unordered_set<int> expanded;
+    bool tasks_requested{false};  // rescan on the next cycle instead of waiting out the interval
+    // threads of the expanded processes, busiest first, as published by the sampler thread
+    std::unordered_map<int, std::vector<TaskTable::Thread>> tasks;
 
     std::deque<float> cpu_history;
     std::deque<float> mem_history;
     std::vector<std::deque<float>> per_core_history;
+    // heatmap layout: cores sorted by NUMA node, and the node of each entry
+    std::vector<int> core_order;
+    std::vector<int> core_group;
+
+    // indexed by Network slot, a slot keeps its history until another interface takes it over
+    std::vector<std::deque<float>> net_history;
 };
 
-int main() {
+namespace {
+    const auto kSampleInterval = std::chrono::milliseconds(10);
+    // thread cpu shares are interval based, a clock tick is 10ms so shorter intervals are mostly noise
+    const auto kTaskScanInterval = std::chrono::milliseconds(500);
+
+    struct Options {
+        bool serve{false};
+        bool attach{false};
+        std::string socket_path{SnapshotFeed::kDefaultSocketPath};
+        std::string shm_path;  // empty: no shared memory export
+        int metrics_port{0};   // 0: no metrics endpoint
+        size_t metrics_top{MetricsExporter::kDefaultTopProcesses};
+        std::string rules_path;
+    };
+
+    void Usage(const char* argv0) {
+        std::cerr << "usage: " << argv0 << " [--serve[=SOCKET] | --attach[=SOCKET]] [--shm[=PATH]]\n"
+                  << "       [--metrics[=PORT] [--metrics-top=N]] [--rules=FILE]\n"
+                  << "  --serve    sample headless and publish snapshots on SOCKET (default "
+                  << SnapshotFeed::kDefaultSocketPath << ")\n"
+                  << "  --attach   render the snapshots published by a running --serve\n"
+                  << "  --shm      also export every snapshot to a shared memory ring at PATH (default "
+                  << MtopShm::kDefaultPath << "), see mtop_shm.hpp\n"
+                  << "  --metrics  sample headless and serve OpenMetrics on 127.0.0.1:PORT (default "
+                  << MetricsExporter::kDefaultPort << ")\n"
+                  << "  --metrics-top  processes exported as series (default "
+                  << MetricsExporter::kDefaultTopProcesses << ")\n"
+                  << "  --rules    evaluate the alert rules in FILE on every snapshot, see alerts.hpp\n";
+    }
+
+    bool ParseOptions(int argc, char** argv, Options& opts) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg(argv[i]);
+            std::string value;
+            size_t eq = arg.find('=');
+            if (eq != std::string::npos) {
+                value = arg.substr(eq + 1);
+                arg.erase(eq);
+            }
+            if (arg == "--serve" || arg == "--attach") {
+                (arg == "--serve" ? opts.serve : opts.attach) = true;
+                if (!value.empty()) opts.socket_path = value;
+            } else if (arg == "--shm") {
+                opts.shm_path = value.empty() ? MtopShm::kDefaultPath : value;
+            } else if (arg == "--metrics") {
+                opts.metrics_port = value.empty() ? MetricsExporter::kDefaultPort : std::atoi(value.c_str());
+                if (opts.metrics_port <= 0 || opts.metrics_port > 65535) return false;
+            } else if (arg == "--rules" && !value.empty()) {
+                opts.rules_path = value;
+            } else if (arg == "--metrics-top" && !value.empty()) {
+                opts.metrics_top = static_cast<size_t>(std::max(0, std::atoi(value.c_str())));
+            } else {
+                return false;
+            }
+        }
+        // an attached viewer has no sampling of its own to export
+        return !opts.attach || (!opts.serve && opts.shm_path.empty() && !opts.metrics_port);
+    }
+
+    std::atomic<bool> g_serving{true};
+
+    bool LoadRules(const Options& opts, AlertEngine& alerts) {
+        if (opts.rules_path.empty()) return true;
+        std::string error;
+        if (alerts.Load(opts.rules_path, error)) return true;
+        std::cerr << "mtop: " << error << "\n";
+        return false;
+    }
+
+    bool OpenExport(const Options& opts, ShmExporter& shm) {
+        if (opts.shm_path.empty()) return true;
+        std::string error;
+        if (shm.Open(error)) return true;
+        std::cerr << "mtop: " << error << "\n";
+        return false;
+    }
+
+    // --serve and/or --metrics: sample without the TUI and only feed the outputs
+    int Headless(const Options& opts) {
+        std::string error;
+        SnapshotServer server(opts.socket_path);
+        if (opts.serve && !server.Listen(error)) {
+            std::cerr << "mtop: " << error << "\n";
+            return 1;
+        }
+        MetricsExporter metrics(opts.metrics_port, opts.metrics_top);
+        if (opts.metrics_port && !metrics.Listen(error)) {
+            std::cerr << "mtop: " << error << "\n";
+            return 1;
+        }
+        ShmExporter shm(opts.shm_path);
+        if (!OpenExport(opts, shm)) return 1;
+        AlertEngine alerts;
+        if (!LoadRules(opts, alerts)) return 1;
+        auto stop = [](int) { g_serving = false; };
+        std::signal(SIGINT, stop);
+        std::signal(SIGTERM, stop);
+        if (opts.serve) std::cerr << "mtop: serving snapshots on " << opts.socket_path << "\n";
+        if (opts.metrics_port) std::cerr << "mtop: serving metrics on 127.0.0.1:" << opts.metrics_port << "\n";
+
+        // viewers may run core breakdown rules of their own
+        Sampler sampler(opts.serve || alerts.NeedsCoreBreakdown());
+        Snapshot snap;
+        while (g_serving.load()) {
+            sampler.Sample(snap);
+            alerts.Evaluate(snap);
+            server.Publish(snap);
+            metrics.Publish(snap);
+            shm.Publish(snap);
+            std::this_thread::sleep_for(kSampleInterval);
+        }
+        return 0;
+    }
+}; // namespace
+
+int main(int argc, char** argv) {
     using namespace ftxui;
 
+    Options opts;
+    if (!ParseOptions(argc, argv, opts)) {
+        Usage(argv[0]);
+        return 2;
+    }
+    if (opts.serve || opts.metrics_port) return Headless(opts);
+    ShmExporter shm(opts.shm_path);
+    if (!OpenExport(opts, shm)) return 1;
+    AlertEngine alerts;
+    if (!LoadRules(opts, alerts)) return 1;
+
     ScreenInteractive screen = ScreenInteractive::Fullscreen();
-    System sys;
 
     std::mutex mtx;
     std::atomic<bool> running{true};
-    std::atomic<bool> show_cores{false};
+    // per-core view cycled with 'c', the bordered graphs only make sense for a handful of cores
+    enum CoreView { kCollapsed = 0, kHeatmap, kGraphs };
+    const size_t kMaxCoreGraphs = 32;
+    std::atomic<int> core_view{kCollapsed};
+    auto heatmap_area = std::make_shared<Heatmap::Area>();
     AppState state;
 
     const int kMaxPoints = 160;
-    std::vector<LinuxParser::CpuTimes> prev_times;
 
     auto push_hist = [&](std::deque<float>& dq, float val) {
         dq.push_back(val);
         if ((int)dq.size() > kMaxPoints) dq.pop_front();
     };
 
-    auto refresh = [&] {
-        AppState s;
-        s.mem_used = sys.MemoryUtilization();
-        s.uptime   = sys.UpTime();
-    
-        std::vector<LinuxParser::CpuTimes> curr_times;
-        if (LinuxParser::ReadCpuTimesAll(curr_times)) {
-            if (prev_times.empty()) {
-                prev_times = curr_times;
-            }
-            const size_t overlap = std::min(prev_times.size(), curr_times.size());
-            if (overlap >= 1) {
-                s.total_cpu = LinuxParser::UtilFromData(prev_times[0], curr_times[0]);
-                std::vector<float> per_core_now;
-            
-                per_core_now.reserve(overlap - 1);
-                for (size_t i = 0; i < overlap - 1; ++i) {
-                    per_core_now.push_back(LinuxParser::UtilFromData(prev_times[i + 1], curr_times[i + 1]));
-                }
-            
-                {
-                    std::lock_guard<std::mutex> lk(mtx);
-    
-                    push_hist(state.cpu_history, s.total_cpu);
-                    push_hist(state.mem_history, s.mem_used);
-    
-                    if (state.per_core_history.size() != per_core_now.size()) {
-                        state.per_core_history.assign(per_core_now.size(), {});
-                    }
-                    for (size_t i = 0; i < per_core_now.size(); ++i) {
-                        push_hist(state.per_core_history[i], per_core_now[i]);
-                    }
-    
-                    state.total_cpu = s.total_cpu;
-                    state.mem_used  = s.mem_used;
-                    state.uptime    = s.uptime;
-                }
+    // the process order belongs to the sampler thread: it is sorted and filtered before taking
+    // the lock, the UI only gets a copy of the indices
+    ProcessView view;
+    std::vector<ProcessView::Key> sort_requests;
+    std::string filter_request;
+    std::string filter_error;
+
+    // folds a new snapshot into the histories, snap gets the previous one back to be refilled
+    auto apply = [&](Snapshot& snap) {
+        alerts.Evaluate(snap);
+
+        bool filter_requested = false;
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            std::swap(sort_requests, state.sort_requests);
+            if (state.filter_requested) {
+                filter_request = state.filter_input;
+                state.filter_requested = false;
+                filter_requested = true;
             }
-            prev_times = std::move(curr_times);
         }
-    
-        auto& processes = sys.Processes();
-        std::sort(processes.begin(), processes.end(),
-                  [](const Process& a, const Process& b) { return b < a; });
-    
-        int count = 0;
-        for (auto& p : processes) {
-            std::string cmd = p.Command();
-            if (cmd.empty()) continue;
-            const int pid = p.Pid();
-            const std::string user = p.User();
-            const float cpu = p.CpuUtilization() * 100.f; // TODO: delta-based per-process
-            const std::string mem = p.Ram();
-            if (cmd.size() > 40) cmd = cmd.substr(0, 37) + "...";
-    
-            s.procs.push_back({
-                std::to_string(pid),
-                user.empty() ? std::string("?") : user,
-                std::to_string(static_cast<int>(cpu)),
-                mem,
-                cmd
-            });
-            if (count++ >= 15) break;
+        for (ProcessView::Key key : sort_requests) view.SortBy(key);
+        sort_requests.clear();
+        filter_error.clear();
+        if (filter_requested) view.SetFilter(filter_request, filter_error);
+        view.Update(snap.procs);
+
+        std::lock_guard<std::mutex> lk(mtx);
+
+        if (!alerts.Empty()) {
+            state.alerts = alerts.Firing();
+            state.alert_pids = alerts.FiringPids();
         }
-    
+
+        push_hist(state.cpu_history, snap.total_cpu);
+        push_hist(state.mem_history, snap.mem_used);
+
+        if (state.per_core_history.size() != snap.cores.size()) {
+            state.per_core_history.assign(snap.cores.size(), {});
+        }
+        if (state.core_order.size() != snap.cores.size() || state.snap.core_nodes != snap.core_nodes) {
+            auto node_of = [&](int core) { return core < (int)snap.core_nodes.size() ? snap.core_nodes[core] : 0; };
+            state.core_order.resize(snap.cores.size());
+            for (size_t i = 0; i < state.core_order.size(); ++i) state.core_order[i] = (int)i;
+            std::stable_sort(state.core_order.begin(), state.core_order.end(),
+                             [&](int a, int b) { return node_of(a) < node_of(b); });
+            state.core_group.resize(state.core_order.size());
+            for (size_t i = 0; i < state.core_order.size(); ++i) state.core_group[i] = node_of(state.core_order[i]);
+        }
+        for (size_t i = 0; i < snap.cores.size(); ++i) {
+            push_hist(state.per_core_history[i], snap.cores[i]);
+        }
+
+        const auto& ifaces = snap.interfaces;
+        state.net_history.resize(ifaces.size());
+        for (size_t i = 0; i < ifaces.size(); ++i) {
+            bool reused = i >= state.snap.interfaces.size() || state.snap.interfaces[i].generation != ifaces[i].generation;
+            if (reused) state.net_history[i].clear();
+            if (ifaces[i].active) push_hist(state.net_history[i], ifaces[i].rx_bytes + ifaces[i].tx_bytes);
+        }
+
+        std::swap(state.snap, snap);
+        state.rows = view.Rows();
+        state.sort_key = view.SortKey();
+        state.sort_descending = view.Descending();
+        state.filter = view.Filter();
+        // an error is only news if the prompt did not change again meanwhile
+        if (filter_requested && !state.filter_requested) state.filter_error = filter_error;
+    };
+
+    // only expanded processes are scanned at thread level. The tables belong to the sampler
+    // thread and are scanned without the lock, the UI only gets busiest first copies swapped in
+    std::unordered_map<int, TaskTable> task_tables;
+    std::unordered_map<int, std::vector<TaskTable::Thread>> staged;
+    std::vector<int> wanted;
+    std::chrono::steady_clock::time_point tasks_scanned;
+    auto scan_tasks = [&] {
+        const auto now = std::chrono::steady_clock::now();
         {
             std::lock_guard<std::mutex> lk(mtx);
-            state.procs = std::move(s.procs);
+            if (!state.tasks_requested && (now - tasks_scanned < kTaskScanInterval ||
+                                           (state.expanded.empty() && task_tables.empty()))) {
+                return;
+            }
+            state.tasks_requested = false;
+            wanted.assign(state.expanded.begin(), state.expanded.end());
         }
-        screen.Post(Event::Custom);
+        tasks_scanned = now;
+
+        auto is_wanted = [&](int pid) { return std::find(wanted.begin(), wanted.end(), pid) != wanted.end(); };
+        for (auto it = task_tables.begin(); it != task_tables.end();) {
+            it = is_wanted(it->first) ? std::next(it) : task_tables.erase(it);
+        }
+        for (int pid : wanted) task_tables.try_emplace(pid, pid);
+        for (auto it = staged.begin(); it != staged.end();) {
+            it = task_tables.count(it->first) ? std::next(it) : staged.erase(it);
+        }
+        for (auto it = task_tables.begin(); it != task_tables.end();) {
+            if (!it->second.Update()) {
+                staged.erase(it->first);
+                it = task_tables.erase(it);
+                continue;
+            }
+            // element wise assignment, the names reuse the staged strings' capacity
+            const auto& threads = it->second.Threads();
+            const auto& by_cpu = it->second.ByCpu();
+            auto& out = staged[it->first];
+            out.resize(by_cpu.size());
+            for (size_t i = 0; i < by_cpu.size(); ++i) out[i] = threads[by_cpu[i]];
+            ++it;
+        }
+
+        std::lock_guard<std::mutex> lk(mtx);
+        std::swap(state.tasks, staged);
+        // processes that exited are collapsed
+        for (int pid : wanted) {
+            if (!state.tasks.count(pid)) state.expanded.erase(pid);
+        }
+    };
+
+    auto set_status = [&](std::string status) {
+        std::lock_guard<std::mutex> lk(mtx);
+        state.feed_status = std::move(status);
     };
 
+    SnapshotClient client(opts.socket_path);
     std::thread sampler([&]{
-        ReadCpuTimesAll(prev_times);
+        if (!opts.attach) {
+            Sampler sampler(alerts.NeedsCoreBreakdown());
+            Snapshot snap;
+            while (running.load()) {
+                sampler.Sample(snap);
+                shm.Publish(snap);
+                apply(snap);
+                scan_tasks();
+                screen.Post(Event::Custom);
+                std::this_thread::sleep_for(kSampleInterval);
+            }
+            return;
+        }
+        // the decoder keeps its own copy since deltas build on it
+        Snapshot feed, snap;
         while (running.load()) {
-            refresh();
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            std::string error;
+            if (client.Connect(error) && running.load()) {
+                set_status("attached to " + opts.socket_path);
+                while (running.load() && client.Receive(feed)) {
+                    snap = feed;
+                    apply(snap);
+                    scan_tasks();
+                    screen.Post(Event::Custom);
+                }
+                error = "feed lost";
+            }
+            set_status("waiting for " + opts.socket_path + " (" + error + ")");
+            screen.Post(Event::Custom);
+            for (int i = 0; i < 10 && running.load(); ++i) std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
     });
 
@@ -148,6 +395,23 @@ int main() {
         };
     };
 
+    // same as graph_from but for unbounded values (bytes/s), scaled to the peak on screen
+    auto graph_peak = [&](const std::deque<float>& hist) {
+        return [&](int width, int height) {
+            std::vector<int> out(width, 0);
+            if (hist.empty() || width <= 0 || height <= 0) return out;
+            int n = (int)hist.size();
+            float peak = 0.f;
+            for (int i = std::max(0, n - width); i < n; ++i) peak = std::max(peak, hist[i]);
+            if (peak <= 0.f) return out;
+            for (int x = 0; x < width; ++x) {
+                int idx = std::max(0, n - width + x);
+                out[x] = std::clamp((int)std::round(hist[idx] / peak * height), 0, height);
+            }
+            return out;
+        };
+    };
+
     auto ui = Renderer([&]{
         std::lock_guard<std::mutex> lk(mtx);
         auto cpu_graphfn = graph_from(state.cpu_history);
@@ -155,9 +419,11 @@ int main() {
         auto header = hbox({
             text("mtop") | bold, 
             filler(), 
-            text("Uptime: " + Utils::ElapsedTime(state.uptime)),
+            text(state.feed_status) | dim,
             text("  "),
-            text("c: cores  q: quit") | dim,
+            text("Uptime: " + Utils::ElapsedTime(state.snap.uptime)),
+            text("  "),
+            text("P/M/N/U/T/I: sort  /: filter  enter: threads  c: cores  q: quit") | dim,
         }) | bgcolor(Color::Black);
 
         auto cpu_graph = vbox({
@@ -192,14 +458,50 @@ int main() {
             }) | flex,
         }) | borderRounded;
 
+        Elements net_rows;
+        net_rows.push_back(hbox({
+            text("IFACE") | bold | size(WIDTH, EQUAL, 10),
+            text("RX/s") | bold | size(WIDTH, EQUAL, 8),
+            text("TX/s") | bold | size(WIDTH, EQUAL, 8),
+            text("PKT/s") | bold | size(WIDTH, EQUAL, 8),
+            text("ERR/DROP") | bold | size(WIDTH, EQUAL, 10),
+            text("RX+TX") | bold | flex,
+        }));
+        for (size_t i = 0; i < state.snap.interfaces.size(); ++i) {
+            const auto& iface = state.snap.interfaces[i];
+            if (!iface.active) continue;
+            net_rows.push_back(hbox({
+                text(iface.name) | size(WIDTH, EQUAL, 10),
+                text(Utils::HumanBytes(iface.rx_bytes)) | size(WIDTH, EQUAL, 8),
+                text(Utils::HumanBytes(iface.tx_bytes)) | size(WIDTH, EQUAL, 8),
+                text(std::to_string(static_cast<long>(iface.rx_packets + iface.tx_packets))) | size(WIDTH, EQUAL, 8),
+                text(std::to_string(static_cast<long>(iface.errors)) + "/" +
+                     std::to_string(static_cast<long>(iface.drops))) | size(WIDTH, EQUAL, 10),
+                graph(graph_peak(state.net_history[i])) | color(Color::Cyan) | flex,
+            }));
+        }
+
+        auto net_panel = vbox({
+            hbox({
+                text("Network") | bold,
+                filler(),
+                text("TCP retrans/s: " + std::to_string(static_cast<long>(state.snap.tcp_retrans))) | dim,
+            }),
+            vbox(std::move(net_rows)) | flex,
+        }) | borderRounded;
+
         Elements core_rows;
-        if (show_cores.load() && !state.per_core_history.empty()) {
+        const int view = core_view.load();
+        if (view == kHeatmap && !state.per_core_history.empty()) {
+            core_rows.push_back(Heatmap::Render(state.per_core_history, state.core_order, state.core_group, heatmap_area) | flex);
+        }
+        if (view == kGraphs && !state.per_core_history.empty()) {
             int cols = 2;
             int i = 0;
             while (i < (int)state.per_core_history.size()) {
                 Elements row;
                 for (int c = 0; c < cols && i < (int)state.per_core_history.size(); ++c, ++i) {
-                    auto label = "cpu" + std::to_string(i);
+                    auto label = "cpu" + std::to_string(i < (int)state.snap.core_ids.size() ? state.snap.core_ids[i] : i);
                     row.push_back(vbox({
                         text(label),
                         graph(graph_from(state.per_core_history[i])) | color(Color::Green) | flex,
@@ -209,40 +511,113 @@ int main() {
             }
         }
 
-        std::vector<Element> rows;
-        rows.push_back(
-            hbox({
-                text("PID") | bold | size(WIDTH, EQUAL, 8),
-                text("USER") | bold | size(WIDTH, EQUAL, 10),
-                text("CPU%") | bold | size(WIDTH, EQUAL, 6),
-                text("MEM(MB)") | bold | size(WIDTH, EQUAL, 10),
-                text("COMMAND") | bold | flex,
-            }) | bgcolor(Color::DarkBlue)
-        );
-
-        for (auto& r: state.procs) {
-            rows.push_back(
-                hbox({
-                    text(r[0]) | size(WIDTH, EQUAL, 8),
-                    text(r[1]) | size(WIDTH, EQUAL, 8),
-                    text(r[2]) | size(WIDTH, EQUAL, 8),
-                    text(r[3]) | size(WIDTH, EQUAL, 8),
-                    text(r[4]) | flex,
-                })
-            );
+        auto column = [&](const char* name, ProcessView::Key key) {
+            if (state.sort_key != key) return std::string(name);
+            return std::string(name) + (state.sort_descending ? "▼" : "▲");
+        };
+        auto table_header = hbox({
+            text(column("PID", ProcessView::Key::kPid)) | bold | size(WIDTH, EQUAL, 8),
+            text(column("USER", ProcessView::Key::kUser)) | bold | size(WIDTH, EQUAL, 10),
+            text(column("CPU%", ProcessView::Key::kCpu)) | bold | size(WIDTH, EQUAL, 6),
+            text(column("MEM(MB)", ProcessView::Key::kRam)) | bold | size(WIDTH, EQUAL, 10),
+            text(column("TIME", ProcessView::Key::kStart)) | bold | size(WIDTH, EQUAL, 10),
+            text(column("IO/s", ProcessView::Key::kIo)) | bold | size(WIDTH, EQUAL, 8),
+            text("COMMAND") | bold | flex,
+        }) | bgcolor(Color::DarkBlue);
+
+        // only build the rows that can be on screen, the list itself may be tens of thousands long
+        const auto& order = state.rows;
+        const size_t visible = static_cast<size_t>(std::max(1, Terminal::Size().dimy));
+        size_t selected = 0;
+        while (selected < order.size() && state.snap.procs[order[selected]].pid != state.selected_pid) ++selected;
+        if (selected == order.size()) selected = 0;
+        if (!order.empty()) state.selected_pid = state.snap.procs[order[selected]].pid;
+        if (selected < state.scroll) state.scroll = selected;
+        if (selected >= state.scroll + visible) state.scroll = selected - visible + 1;
+        state.scroll = std::min(state.scroll, order.size());
+
+        Elements rows;
+        for (size_t i = state.scroll; i < order.size() && i < state.scroll + visible; ++i) {
+            const ProcessRow& r = state.snap.procs[order[i]];
+            const bool expanded = state.expanded.count(r.pid) > 0;
+            std::string cmd = r.command;
+            if (cmd.size() > 40) cmd = cmd.substr(0, 37) + "...";
+            auto row = hbox({
+                text(std::to_string(r.pid)) | size(WIDTH, EQUAL, 8),
+                text(r.user.empty() ? std::string("?") : r.user) | size(WIDTH, EQUAL, 10),
+                text(std::to_string(static_cast<int>(r.cpu * 100.f))) | size(WIDTH, EQUAL, 6),
+                text(std::to_string(r.ram_kb / 1024)) | size(WIDTH, EQUAL, 10),
+                text(Utils::ElapsedTime(std::max(0L, state.snap.uptime - r.start))) | size(WIDTH, EQUAL, 10),
+                text(r.io < 0.f ? std::string("-") : Utils::HumanBytes(r.io)) | size(WIDTH, EQUAL, 8),
+                text((expanded ? "▾ " : "") + cmd) | flex,
+            });
+            if (state.alert_pids.count(r.pid)) row = row | bgcolor(Color::Red) | bold;
+            if (i == selected) row = row | inverted | focus;
+            rows.push_back(row);
+            auto task = expanded ? state.tasks.find(r.pid) : state.tasks.end();
+            if (task == state.tasks.end()) continue;
+
+            // busiest threads first: tid, state, interval cpu, last cpu, name
+            const auto& threads = task->second;
+            const size_t shown = std::min(threads.size(), visible);
+            for (size_t t = 0; t < shown; ++t) {
+                const TaskTable::Thread& thread = threads[t];
+                rows.push_back(hbox({
+                    text("  " + std::to_string(thread.tid)) | size(WIDTH, EQUAL, 8),
+                    text(std::string(1, thread.state)) | size(WIDTH, EQUAL, 10),
+                    text(std::to_string(static_cast<int>(thread.cpu * 100.f))) | size(WIDTH, EQUAL, 6),
+                    text(thread.processor < 0 ? std::string("-") : "cpu" + std::to_string(thread.processor)) | size(WIDTH, EQUAL, 10),
+                    text("") | size(WIDTH, EQUAL, 18),
+                    text((t + 1 == threads.size() ? "└ " : "├ ") + thread.name) | flex,
+                }) | dim);
+            }
+            if (shown < threads.size()) {
+                rows.push_back(text("  └ " + std::to_string(threads.size() - shown) + " more threads") | dim);
+            }
         }
 
-        auto table = vbox(std::move(rows)) | border;
+        Element filter_bar = emptyElement();
+        if (state.filtering || !state.filter.empty()) {
+            filter_bar = hbox({
+                text("/" + (state.filtering ? state.filter_input : state.filter)) | bold,
+                text(state.filtering ? "_" : ""),
+                filler(),
+                text(state.filter_error.empty() ? std::to_string(order.size()) + "/" + std::to_string(state.snap.procs.size())
+                                                : state.filter_error) | dim,
+            });
+        }
+
+        auto table = vbox({
+            table_header,
+            vbox(std::move(rows)) | yframe | flex,
+        }) | border;
+
+        Elements alert_line;
+        for (const auto& a : state.alerts) {
+            std::string value = std::to_string(a.value);
+            alert_line.push_back(text(" " + a.rule + (a.entity.empty() ? "" : "[" + a.entity + "]") + "=" +
+                                      value.substr(0, value.find('.') + 3) + " "));
+        }
+        auto alert_bar = alert_line.empty() ? emptyElement() : hbox({
+            text("ALERT") | bold,
+            hbox(std::move(alert_line)),
+            filler(),
+        }) | bgcolor(Color::Red);
 
         auto display = vbox({
             header,
+            alert_bar,
             separator(),
-            hbox({ cpu_graph | flex, separator(), mem_graph | flex }),
+            hbox({ cpu_graph | flex, separator(), mem_graph | flex, separator(), net_panel | flex }),
             separator(),
-            (show_cores ? text("Per-core: expanded (press 'c' to collapse)")
-                        : text("Per-core: collapsed (press 'c' to expand)")) | dim,
+            text(view == kCollapsed ? "Per-core: collapsed (press 'c' for heatmap)"
+                 : view == kHeatmap ? (state.per_core_history.size() > kMaxCoreGraphs
+                                           ? "Per-core: heatmap (press 'c' to collapse)"
+                                           : "Per-core: heatmap (press 'c' for graphs)")
+                                    : "Per-core: graphs (press 'c' to collapse)") | dim,
             vbox(std::move(core_rows)) | flex,
             separator(),
+            filter_bar,
             table | flex,
           }) | flex
             | bgcolor(LinearGradient()
@@ -253,14 +628,109 @@ int main() {
         return display;
     });
     
+    // '/' prompt: typing filters live, Return keeps the filter, Escape drops it
+    auto filter_key = [&](const Event& e) {
+        std::lock_guard<std::mutex> lk(mtx);
+        if (e == Event::Escape) {
+            state.filter_input.clear();
+            state.filtering = false;
+        } else if (e == Event::Return) {
+            state.filtering = false;
+            return;
+        } else if (e == Event::Backspace) {
+            if (!state.filter_input.empty()) state.filter_input.pop_back();
+        } else if (e.is_character()) {
+            state.filter_input += e.character();
+        } else {
+            return;
+        }
+        state.filter_error.clear();
+        state.filter_requested = true;
+    };
+
+    const std::array<std::pair<char, ProcessView::Key>, 6> sort_keys{{
+        {'p', ProcessView::Key::kCpu}, {'m', ProcessView::Key::kRam}, {'n', ProcessView::Key::kPid},
+        {'u', ProcessView::Key::kUser}, {'t', ProcessView::Key::kStart}, {'i', ProcessView::Key::kIo},
+    }};
+
+    // selection moves over the displayed order, it is kept as a pid so re-sorts do not move it
+    auto select_by = [&](long delta) {
+        std::lock_guard<std::mutex> lk(mtx);
+        const auto& order = state.rows;
+        if (order.empty()) return;
+        long at = 0;
+        while (at < (long)order.size() && state.snap.procs[order[at]].pid != state.selected_pid) ++at;
+        if (at == (long)order.size()) at = 0;
+        at = std::clamp(at + delta, 0L, (long)order.size() - 1);
+        state.selected_pid = state.snap.procs[order[at]].pid;
+    };
+
+    // expand / collapse the selected process, the sampler thread picks it up on its next cycle
+    auto expand = [&](int mode) {
+        std::lock_guard<std::mutex> lk(mtx);
+        const int pid = state.selected_pid;
+        if (pid < 0) return;
+        const bool expanded = state.expanded.count(pid) > 0;
+        if (expanded ? mode > 0 : mode < 0) return;
+        if (expanded) state.expanded.erase(pid);
+        else state.expanded.insert(pid);
+        state.tasks_requested = true;
+    };
+
     auto ui_with_keys = CatchEvent(ui, [&](Event e){
+        {
+            std::unique_lock<std::mutex> lk(mtx);
+            if (state.filtering) {
+                lk.unlock();
+                filter_key(e);
+                screen.Post(Event::Custom);
+                return true;
+            }
+        }
+        if (e == Event::Character('/')) {
+            std::lock_guard<std::mutex> lk(mtx);
+            state.filtering = true;
+            state.filter_input = state.filter;
+            screen.Post(Event::Custom);
+            return true;
+        }
+        const long page = std::max(1, Terminal::Size().dimy / 2);
+        const std::array<std::pair<Event, long>, 6> moves{{
+            {Event::ArrowUp, -1}, {Event::ArrowDown, 1}, {Event::PageUp, -page}, {Event::PageDown, page},
+            {Event::Home, std::numeric_limits<int>::min()}, {Event::End, std::numeric_limits<int>::max()},
+        }};
+        for (const auto& [event, delta] : moves) {
+            if (e == event) {
+                select_by(delta);
+                screen.Post(Event::Custom);
+                return true;
+            }
+        }
+        if (e == Event::Return || e == Event::ArrowRight || e == Event::ArrowLeft) {
+            expand(e == Event::Return ? 0 : e == Event::ArrowRight ? 1 : -1);
+            screen.Post(Event::Custom);
+            return true;
+        }
+        for (const auto& [c, key] : sort_keys) {
+            if (e == Event::Character(c) || e == Event::Character(static_cast<char>(c - 'a' + 'A'))) {
+                std::lock_guard<std::mutex> lk(mtx);
+                state.sort_requests.push_back(key);
+                screen.Post(Event::Custom);
+                return true;
+            }
+        }
         if (e == Event::Character('q') || e == Event::Character('Q')) {
             running = false;
             screen.Exit();
             return true;
         }
         if (e == Event::Character('c') || e == Event::Character('C')) {
-            show_cores = !show_cores.load();
+            int next = (core_view.load() + 1) % 3;
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                if (next == kGraphs && state.per_core_history.size() > kMaxCoreGraphs) next = kCollapsed;
+            }
+            core_view = next;
             screen.Post(Event::Custom);
             return true;
         }
@@ -270,6 +740,7 @@ int main() {
     // Blocking until the component exits 
     screen.Loop(ui_with_keys);
     running = false;
+    client.Shutdown();
     sampler.join();
     return 0;
 }
\ No newline at end of file
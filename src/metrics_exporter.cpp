@@ -0,0 +1,253 @@
+#include "../include/metrics_exporter.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+    const size_t kMaxCommandLabel = 64;
+    // scrapers are few and local, anything beyond this is refused outright
+    const size_t kMaxClients = 16;
+    // whole request/reply budget of one connection
+    const std::chrono::milliseconds kClientTimeout{1000};
+
+    void Family(std::string& out, const char* name, const char* help) {
+        out += "# TYPE ";
+        out += name;
+        out += " gauge\n# HELP ";
+        out += name;
+        out += ' ';
+        out += help;
+        out += '\n';
+    }
+
+    // counts, bytes and seconds are integral and printed in full, fractions come from floats
+    // and 9 significant digits round trip those exactly
+    void Value(std::string& out, double value) {
+        char buf[40];
+        const bool integral = std::fabs(value) < 9007199254740992.0 && value == std::trunc(value);
+        int n = std::snprintf(buf, sizeof(buf), integral ? " %.0f\n" : " %.9g\n", value);
+        out.append(buf, n);
+    }
+
+    // label values escape backslash, double quote and newline
+    void Label(std::string& out, const char* name, const std::string& value, bool first) {
+        if (!first) out += ',';
+        out += name;
+        out += "=\"";
+        for (char c : value) {
+            if (c == '\\') out += "\\\\";
+            else if (c == '"') out += "\\\"";
+            else if (c == '\n') out += "\\n";
+            else out += c;
+        }
+        out += '"';
+    }
+
+    // argv[0] without its directory, a stable and short label unlike the whole command line
+    std::string CommandLabel(const std::string& command) {
+        std::string exe = command.substr(0, command.find(' '));
+        size_t slash = exe.rfind('/');
+        if (slash != std::string::npos && slash + 1 < exe.size()) exe.erase(0, slash + 1);
+        if (exe.size() > kMaxCommandLabel) exe.resize(kMaxCommandLabel);
+        return exe;
+    }
+
+    void Render(const Snapshot& snap, size_t top, std::string& out) {
+        out.clear();
+        Family(out, "mtop_cpu_utilization", "Fraction of time all cpus were busy over the last interval.");
+        out += "mtop_cpu_utilization";
+        Value(out, snap.total_cpu);
+
+        Family(out, "mtop_core_utilization", "Fraction of time one cpu was busy over the last interval.");
+        for (size_t i = 0; i < snap.cores.size(); ++i) {
+            out += "mtop_core_utilization{";
+            Label(out, "cpu", std::to_string(i < snap.core_ids.size() ? snap.core_ids[i] : static_cast<int>(i)), true);
+            Label(out, "node", std::to_string(i < snap.core_nodes.size() ? snap.core_nodes[i] : 0), false);
+            out += '}';
+            Value(out, snap.cores[i]);
+        }
+
+        Family(out, "mtop_memory_utilization", "Fraction of memory in use.");
+        out += "mtop_memory_utilization";
+        Value(out, snap.mem_used);
+
+        Family(out, "mtop_uptime_seconds", "Seconds since boot.");
+        out += "mtop_uptime_seconds";
+        Value(out, static_cast<double>(snap.uptime));
+
+        struct NetFamily {
+            const char* name;
+            const char* help;
+            float Network::Interface::*field;
+        };
+        const NetFamily net[] = {
+            {"mtop_network_receive_bytes_per_second", "Bytes received per second.", &Network::Interface::rx_bytes},
+            {"mtop_network_transmit_bytes_per_second", "Bytes transmitted per second.", &Network::Interface::tx_bytes},
+            {"mtop_network_receive_packets_per_second", "Packets received per second.", &Network::Interface::rx_packets},
+            {"mtop_network_transmit_packets_per_second", "Packets transmitted per second.", &Network::Interface::tx_packets},
+            {"mtop_network_errors_per_second", "Receive and transmit errors per second.", &Network::Interface::errors},
+            {"mtop_network_drops_per_second", "Receive and transmit drops per second.", &Network::Interface::drops},
+        };
+        for (const NetFamily& family : net) {
+            Family(out, family.name, family.help);
+            for (const Network::Interface& iface : snap.interfaces) {
+                if (!iface.active) continue;
+                out += family.name;
+                out += '{';
+                Label(out, "interface", iface.name, true);
+                out += '}';
+                Value(out, iface.*family.field);
+            }
+        }
+
+        Family(out, "mtop_tcp_retransmits_per_second", "TCP segments retransmitted per second.");
+        out += "mtop_tcp_retransmits_per_second";
+        Value(out, snap.tcp_retrans);
+
+        const size_t rows = std::min(top, snap.procs.size());
+        Family(out, "mtop_process_cpu_utilization", "Cpu use of the top processes over about the last second, as a fraction of one cpu.");
+        for (size_t i = 0; i < rows; ++i) {
+            const ProcessRow& row = snap.procs[i];
+            out += "mtop_process_cpu_utilization{";
+            Label(out, "pid", std::to_string(row.pid), true);
+            Label(out, "user", row.user, false);
+            Label(out, "command", CommandLabel(row.command), false);
+            out += '}';
+            Value(out, row.cpu);
+        }
+        Family(out, "mtop_process_resident_bytes", "Resident memory of the top processes.");
+        for (size_t i = 0; i < rows; ++i) {
+            const ProcessRow& row = snap.procs[i];
+            out += "mtop_process_resident_bytes{";
+            Label(out, "pid", std::to_string(row.pid), true);
+            Label(out, "user", row.user, false);
+            Label(out, "command", CommandLabel(row.command), false);
+            out += '}';
+            Value(out, static_cast<double>(row.ram_kb) * 1024.0);
+        }
+        out += "# EOF\n";
+    }
+}; // namespace
+
+MetricsExporter::MetricsExporter(int port, size_t top_processes)
+    : port_(port), top_processes_(top_processes), current_(std::make_shared<std::string>("# EOF\n")) {}
+
+MetricsExporter::~MetricsExporter() {
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+    if (listen_fd_ >= 0) close(listen_fd_);
+}
+
+bool MetricsExporter::Listen(std::string& error) {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int one = 1;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port_));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (listen_fd_ < 0 || setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+        bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listen_fd_, 16) != 0) {
+        error = "127.0.0.1:" + std::to_string(port_) + ": " + std::strerror(errno);
+        if (listen_fd_ >= 0) close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    running_ = true;
+    thread_ = std::thread([this] { Serve(); });
+    return true;
+}
+
+void MetricsExporter::Publish(const Snapshot& snap) {
+    // the spare buffer keeps its capacity between cycles unless a slow scrape still holds it
+    if (!spare_ || spare_.use_count() > 1) spare_ = std::make_shared<std::string>();
+    Render(snap, top_processes_, *spare_);
+    std::lock_guard<std::mutex> lk(mtx_);
+    std::swap(current_, spare_);
+}
+
+void MetricsExporter::Serve() {
+    std::vector<Client> clients;
+    std::vector<pollfd> fds;
+    while (running_.load()) {
+        fds.assign(1, pollfd{listen_fd_, POLLIN, 0});
+        for (const Client& c : clients) fds.push_back(pollfd{c.fd, static_cast<short>(c.body ? POLLOUT : POLLIN), 0});
+        if (poll(fds.data(), fds.size(), 200) < 0 && errno != EINTR) continue;
+
+        const auto now = std::chrono::steady_clock::now();
+        size_t kept = 0;
+        for (size_t i = 0; i < clients.size(); ++i) {
+            Client& c = clients[i];
+            bool open = now < c.deadline;
+            if (open && fds[i + 1].revents) open = c.body ? Write(c) : Read(c);
+            if (!open) {
+                close(c.fd);
+                continue;
+            }
+            if (kept != i) clients[kept] = std::move(c);
+            ++kept;
+        }
+        clients.resize(kept);
+
+        if (fds[0].revents & POLLIN) {
+            int fd;
+            while ((fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                if (clients.size() >= kMaxClients) {
+                    close(fd);
+                    continue;
+                }
+                clients.push_back(Client{fd, now + kClientTimeout, {}, {}, nullptr, 0});
+            }
+        }
+    }
+    for (Client& c : clients) close(c.fd);
+}
+
+bool MetricsExporter::Read(Client& client) {
+    // only the request line matters, read until the end of the headers
+    char chunk[1024];
+    while (true) {
+        ssize_t n = recv(client.fd, chunk, sizeof(chunk), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        if (n <= 0) return false;
+        client.request.append(chunk, static_cast<size_t>(n));
+        if (client.request.find("\r\n\r\n") != std::string::npos || client.request.size() >= 8192) break;
+    }
+
+    const bool metrics = client.request.rfind("GET /metrics ", 0) == 0 || client.request.rfind("GET / ", 0) == 0;
+    if (!metrics) {
+        client.header = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        client.body = std::make_shared<std::string>();
+    } else {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            client.body = current_;
+        }
+        client.header = "HTTP/1.1 200 OK\r\n"
+                        "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+                        "Content-Length: " + std::to_string(client.body->size()) + "\r\n"
+                        "Connection: close\r\n\r\n";
+    }
+    return Write(client);
+}
+
+bool MetricsExporter::Write(Client& client) {
+    while (true) {
+        const bool in_header = client.sent < client.header.size();
+        const std::string& part = in_header ? client.header : *client.body;
+        const size_t offset = in_header ? client.sent : client.sent - client.header.size();
+        if (!in_header && offset >= part.size()) return false;
+        ssize_t n = send(client.fd, part.data() + offset, part.size() - offset, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        if (n <= 0) return false;
+        client.sent += static_cast<size_t>(n);
+    }
+}
@@ -0,0 +1,95 @@
+#include "../include/network.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+    float Rate(unsigned long long prev, unsigned long long curr, float seconds) {
+        // counters can go backwards when a driver resets them, treat it as no traffic
+        if (curr < prev || seconds <= 0.f) return 0.f;
+        return static_cast<float>(curr - prev) / seconds;
+    }
+}; // namespace
+
+Network::Network(bool tcp_retransmits) {
+    dev_fd_ = open((LinuxParser::kProcDirectory + LinuxParser::kNetDevFilename).c_str(), O_RDONLY | O_CLOEXEC);
+    if (tcp_retransmits) {
+        snmp_fd_ = open((LinuxParser::kProcDirectory + LinuxParser::kNetSnmpFilename).c_str(), O_RDONLY | O_CLOEXEC);
+    }
+}
+
+Network::~Network() {
+    if (dev_fd_ >= 0) close(dev_fd_);
+    if (snmp_fd_ >= 0) close(snmp_fd_);
+}
+
+const std::vector<Network::Interface>& Network::Interfaces() const { return interfaces_; }
+float Network::TcpRetransmits() const { return tcp_retrans_; }
+
+size_t Network::SlotFor(const std::string& name, size_t hint) {
+    // /proc/net/dev keeps its order between reads, so the slot used last time is the usual hit
+    if (hint < interfaces_.size() && interfaces_[hint].active && interfaces_[hint].name == name) return hint;
+    auto it = index_.find(name);
+    if (it != index_.end()) return it->second;
+
+    size_t slot = 0;
+    while (slot < interfaces_.size() && (interfaces_[slot].active || seen_[slot])) ++slot;
+    if (slot == interfaces_.size()) {
+        interfaces_.emplace_back();
+        prev_.emplace_back();
+        seen_.push_back(false);
+    }
+    Interface& iface = interfaces_[slot];
+    iface.name = name;
+    iface.active = true;
+    ++iface.generation;
+    prev_[slot].name.clear();  // no baseline yet, the first sample only primes the counters
+    index_.emplace(name, slot);
+    return slot;
+}
+
+bool Network::Update() {
+    if (!LinuxParser::ReadFd(dev_fd_, buffer_)) return false;
+    if (!LinuxParser::ParseNetDev(buffer_, counters_)) return false;
+
+    auto now = std::chrono::steady_clock::now();
+    float seconds = primed_ ? std::chrono::duration<float>(now - last_).count() : 0.f;
+    last_ = now;
+    primed_ = true;
+
+    std::fill(seen_.begin(), seen_.end(), false);
+    for (size_t i = 0; i < counters_.size(); ++i) {
+        const LinuxParser::NetDevCounters& c = counters_[i];
+        size_t slot = SlotFor(c.name, i);
+        seen_[slot] = true;
+        Interface& iface = interfaces_[slot];
+        LinuxParser::NetDevCounters& prev = prev_[slot];
+        if (prev.name.empty()) {
+            iface.rx_bytes = iface.tx_bytes = iface.rx_packets = iface.tx_packets = 0.f;
+            iface.errors = iface.drops = 0.f;
+        } else {
+            iface.rx_bytes = Rate(prev.rx_bytes, c.rx_bytes, seconds);
+            iface.tx_bytes = Rate(prev.tx_bytes, c.tx_bytes, seconds);
+            iface.rx_packets = Rate(prev.rx_packets, c.rx_packets, seconds);
+            iface.tx_packets = Rate(prev.tx_packets, c.tx_packets, seconds);
+            iface.errors = Rate(prev.rx_errs + prev.tx_errs, c.rx_errs + c.tx_errs, seconds);
+            iface.drops = Rate(prev.rx_drop + prev.tx_drop, c.rx_drop + c.tx_drop, seconds);
+        }
+        prev = c;
+    }
+
+    for (size_t slot = 0; slot < interfaces_.size(); ++slot) {
+        Interface& iface = interfaces_[slot];
+        if (seen_[slot] || !iface.active) continue;
+        index_.erase(iface.name);
+        iface.active = false;
+        iface.rx_bytes = iface.tx_bytes = iface.rx_packets = iface.tx_packets = 0.f;
+        iface.errors = iface.drops = 0.f;
+    }
+
+    unsigned long long retrans = 0;
+    if (LinuxParser::ReadFd(snmp_fd_, buffer_) && LinuxParser::ParseTcpRetransSegs(buffer_, retrans)) {
+        tcp_retrans_ = Rate(prev_retrans_, retrans, seconds);
+        prev_retrans_ = retrans;
+    }
+    return true;
+}
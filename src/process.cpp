@@ -1,27 +1,87 @@
 #include "../include/process.hpp"
-#include "../include/linux_parser.hpp"
+#include <algorithm>
+#include <cstdio>
 #include <unistd.h>
 
+namespace {
+    // cpu and io rates are taken over at least this many seconds
+    const double kRateInterval = 1.0;
+}; // namespace
+
 Process::Process(int pid): pid_(pid) {}
-int Process::Pid() { return pid_; }
-std::string Process::User() { return LinuxParser::User(pid_); }
-std::string Process::Command() { return LinuxParser::Command(pid_); }
-
-float Process::CpuUtilization() {
-    long total_time = LinuxParser::ActiveJiffies(pid_);
-    long hertz = sysconf(_SC_CLK_TCK);
-    long seconds = LinuxParser::UpTime() - (LinuxParser::UpTime(pid_));
-    if (seconds <= 0) return 0.f;
-    float cpu = (static_cast<float>(total_time) / static_cast<float>(hertz)) / static_cast<float>(seconds);
-    return cpu;
+int Process::Pid() const { return pid_; }
+const std::string& Process::User() const { return user_; }
+const std::string& Process::Command() const { return command_; }
+float Process::CpuUtilization() const { return cpu_; }
+long Process::RamKb() const { return ram_kb_; }
+long int Process::UpTime() const { return uptime_; }
+long Process::StartTime() const { return start_; }
+float Process::IoRate() const { return io_rate_; }
+unsigned Process::Generation() const { return generation_; }
+
+void Process::Load(Cycle& cycle) {
+    command_ = LinuxParser::Command(pid_);
+    std::string uid = LinuxParser::Uid(pid_);
+    auto it = cycle.users.find(uid);
+    if (it == cycle.users.end()) it = cycle.users.emplace(uid, LinuxParser::UserByUid(uid)).first;
+    user_ = it->second;
+    generation_ = ++cycle.loads;
 }
 
-std::string Process::Ram() { return LinuxParser::Ram(pid_); }
+bool Process::Update(Cycle& cycle) {
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/%d/stat", pid_);
+    if (!LinuxParser::ReadPath(path, cycle.buf) || !LinuxParser::ParseProcStat(cycle.buf, cycle.stat)) return false;
+    const LinuxParser::ProcStat& stat = cycle.stat;
+
+    // a new start time is a reused pid, a new comm an exec: both invalidate the cached strings
+    if (stat.starttime != starttime_ || stat.comm != comm_) {
+        if (stat.starttime != starttime_) {
+            cpu_time_ = 0.0;
+            io_readable_ = true;
+            io_time_ = 0.0;
+            io_rate_ = -1.f;
+        }
+        starttime_ = stat.starttime;
+        comm_ = stat.comm;
+        Load(cycle);
+    }
 
-long int Process::UpTime() { return LinuxParser::UpTime(pid_); }
+    start_ = static_cast<long>(starttime_ / cycle.hertz);
+    uptime_ = cycle.uptime > start_ ? cycle.uptime - start_ : 0;
+    // interval share over at least kRateInterval, a clock tick is 10ms so shorter ones are mostly noise.
+    // waited for children (cutime/cstime) only count towards the lifetime share of a fresh entry
+    const long ticks = stat.utime + stat.stime;
+    if (cpu_time_ == 0.0) {
+        long total = ticks + stat.cutime + stat.cstime;
+        cpu_ = uptime_ > 0 ? (static_cast<float>(total) / static_cast<float>(cycle.hertz)) / static_cast<float>(uptime_) : 0.f;
+        cpu_ticks_ = ticks;
+        cpu_time_ = cycle.now;
+    } else if (cycle.now - cpu_time_ >= kRateInterval) {
+        cpu_ = static_cast<float>(static_cast<double>(std::max(0L, ticks - cpu_ticks_)) / cycle.hertz / (cycle.now - cpu_time_));
+        cpu_ticks_ = ticks;
+        cpu_time_ = cycle.now;
+    }
+    ram_kb_ = stat.rss * cycle.page_kb;
+
+    // other users' io is root only, stop trying after the first refusal. Like the cpu share the
+    // rate spans at least kRateInterval, in between the file is not even read
+    if (io_readable_ && (io_time_ == 0.0 || cycle.now - io_time_ >= kRateInterval)) {
+        std::snprintf(path, sizeof(path), "/proc/%d/io", pid_);
+        unsigned long long read_bytes = 0, write_bytes = 0;
+        if (LinuxParser::ReadPath(path, cycle.buf) && LinuxParser::ParseProcIo(cycle.buf, read_bytes, write_bytes)) {
+            unsigned long long bytes = read_bytes + write_bytes;
+            if (io_time_ > 0.0) io_rate_ = static_cast<float>((bytes >= io_bytes_ ? bytes - io_bytes_ : 0) / (cycle.now - io_time_));
+            io_bytes_ = bytes;
+            io_time_ = cycle.now;
+        } else {
+            io_readable_ = false;
+            io_rate_ = -1.f;
+        }
+    }
+    return true;
+}
 
 bool Process::operator<(Process const& a) const {
-    float lhs = const_cast<Process*>(this)->CpuUtilization();
-    float rhs = const_cast<Process&>(a).CpuUtilization();
-    return lhs < rhs;
-}
\ No newline at end of file
+    return cpu_ < a.cpu_;
+}
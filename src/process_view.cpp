@@ -0,0 +1,105 @@
+#include "../include/process_view.hpp"
+#include "../include/utils.hpp"
+
+namespace {
+    const char kRegexPrefix[] = "re:";
+
+    // the direction a key starts in: biggest consumers, newest processes, lowest pid / name first
+    bool DefaultDescending(ProcessView::Key key) {
+        return key != ProcessView::Key::kPid && key != ProcessView::Key::kUser;
+    }
+}; // namespace
+
+void ProcessView::SortBy(Key key) {
+    descending_ = key == key_ ? !descending_ : DefaultDescending(key);
+    key_ = key;
+}
+
+ProcessView::Key ProcessView::SortKey() const { return key_; }
+bool ProcessView::Descending() const { return descending_; }
+const std::string& ProcessView::Filter() const { return filter_; }
+const std::vector<int>& ProcessView::Rows() const { return rows_; }
+
+bool ProcessView::SetFilter(const std::string& filter, std::string& error) {
+    if (filter == filter_) return true;
+    const bool regex = filter.compare(0, sizeof(kRegexPrefix) - 1, kRegexPrefix) == 0;
+    if (regex) {
+        try {
+            pattern_ = std::regex(filter.substr(sizeof(kRegexPrefix) - 1), std::regex::ECMAScript | std::regex::optimize);
+        } catch (const std::regex_error& e) {
+            error = e.what();
+            return false;
+        }
+    }
+    filter_ = filter;
+    regex_ = regex;
+    verdicts_.clear();
+    return true;
+}
+
+bool ProcessView::Matches(const ProcessRow& row) {
+    if (filter_.empty()) return true;
+    auto it = verdicts_.find(row.pid);
+    if (it != verdicts_.end() && it->second.generation == row.generation) {
+        return it->second.match;
+    }
+    bool match;
+    if (regex_) {
+        match = std::regex_search(row.command, pattern_) || std::regex_search(row.user, pattern_);
+    } else {
+        match = row.command.find(filter_) != std::string::npos || row.user.find(filter_) != std::string::npos;
+    }
+    verdicts_[row.pid] = Verdict{row.generation, match};
+    return match;
+}
+
+void ProcessView::Update(const std::vector<ProcessRow>& rows) {
+    // most pids carry over between cycles, so this mostly overwrites existing entries
+    ++epoch_;
+    for (size_t i = 0; i < rows.size(); ++i) slot_[rows[i].pid] = Slot{static_cast<int>(i), epoch_};
+    if (slot_.size() != rows.size()) {
+        for (auto it = slot_.begin(); it != slot_.end();) {
+            it = it->second.seen == epoch_ ? std::next(it) : slot_.erase(it);
+        }
+    }
+
+    // last order first, so the sort below mostly finds long runs; then the new pids
+    rows_.clear();
+    placed_.assign(rows.size(), 0);
+    for (int pid : order_) {
+        auto it = slot_.find(pid);
+        if (it == slot_.end() || placed_[it->second.index]) continue;
+        placed_[it->second.index] = 1;
+        if (Matches(rows[it->second.index])) rows_.push_back(it->second.index);
+    }
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (!placed_[i] && Matches(rows[i])) rows_.push_back(static_cast<int>(i));
+    }
+
+    auto less = [&](int a, int b) {
+        const ProcessRow& x = rows[a];
+        const ProcessRow& y = rows[b];
+        int c = 0;
+        switch (key_) {
+            case Key::kCpu: c = (x.cpu > y.cpu) - (x.cpu < y.cpu); break;
+            case Key::kRam: c = (x.ram_kb > y.ram_kb) - (x.ram_kb < y.ram_kb); break;
+            case Key::kPid: break;
+            case Key::kUser: c = x.user.compare(y.user); break;
+            case Key::kStart: c = (x.start > y.start) - (x.start < y.start); break;
+            case Key::kIo: c = (x.io > y.io) - (x.io < y.io); break;
+        }
+        if (c == 0) return x.pid < y.pid;
+        return descending_ ? c > 0 : c < 0;
+    };
+    Utils::AdaptiveSort(rows_.begin(), rows_.end(), less);
+
+    order_.resize(rows_.size());
+    for (size_t i = 0; i < rows_.size(); ++i) order_[i] = rows[rows_[i]].pid;
+
+    // drop the verdicts of pids that are long gone
+    if (verdicts_.size() > 2 * rows.size() + 64) {
+        for (auto it = verdicts_.begin(); it != verdicts_.end();) {
+            it = slot_.count(it->first) ? std::next(it) : verdicts_.erase(it);
+        }
+    }
+}
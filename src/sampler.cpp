@@ -0,0 +1,57 @@
+#include "../include/sampler.hpp"
+#include "../include/linux_parser.hpp"
+
+Sampler::Sampler(bool breakdown) : breakdown_(breakdown), cores_(breakdown), cpu_nodes_(LinuxParser::CpuNodes()) {
+    // prime the delta based counters so the first Sample() already has a baseline
+    cores_.Update();
+    net_.Update();
+}
+
+void Sampler::Sample(Snapshot& out) {
+    out.seq = ++seq_;
+    out.mem_used = sys_.MemoryUtilization();
+    out.uptime = sys_.UpTime();
+
+    if (cores_.Update() && cores_.Count() >= 1) {
+        const auto& util = cores_.Utilization();
+        const auto& ids = cores_.CpuIds();
+        out.total_cpu = util[0];
+        out.cores.assign(util.begin() + 1, util.end());
+        if (breakdown_) {
+            out.core_user.assign(cores_.User().begin() + 1, cores_.User().end());
+            out.core_system.assign(cores_.System().begin() + 1, cores_.System().end());
+            out.core_iowait.assign(cores_.IOwait().begin() + 1, cores_.IOwait().end());
+            out.core_steal.assign(cores_.Steal().begin() + 1, cores_.Steal().end());
+        }
+        out.core_ids.assign(ids.begin() + 1, ids.end());
+        out.core_nodes.resize(out.cores.size());
+        for (size_t i = 0; i < out.cores.size(); ++i) {
+            int id = ids[i + 1];
+            out.core_nodes[i] = id >= 0 && id < (int)cpu_nodes_.size() ? cpu_nodes_[id] : 0;
+        }
+    }
+
+    if (net_.Update()) {
+        out.interfaces = net_.Interfaces();
+        out.tcp_retrans = net_.TcpRetransmits();
+    }
+
+    // every user space process (kernel threads have no command line), in System's cpu order.
+    // rows are overwritten in place so their strings keep their capacity between cycles
+    auto& processes = sys_.Processes();
+    size_t rows = 0;
+    for (const auto& p : processes) {
+        if (p.Command().empty()) continue;
+        if (rows == out.procs.size()) out.procs.emplace_back();
+        ProcessRow& row = out.procs[rows++];
+        row.pid = p.Pid();
+        row.cpu = p.CpuUtilization();
+        row.ram_kb = p.RamKb();
+        row.start = p.StartTime();
+        row.io = p.IoRate();
+        row.user = p.User();
+        row.command = p.Command();
+        row.generation = p.Generation();
+    }
+    out.procs.resize(rows);
+}
@@ -0,0 +1,128 @@
+#include "../include/shm_export.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <sys/file.h>
+
+namespace {
+    template <size_t N>
+    void CopyString(char (&out)[N], const std::string& in) {
+        size_t n = std::min(in.size(), N - 1);
+        std::memcpy(out, in.data(), n);
+        out[n] = '\0';
+    }
+}; // namespace
+
+ShmExporter::ShmExporter(std::string path) : path_(std::move(path)) {}
+
+ShmExporter::~ShmExporter() {
+    if (region_) {
+        munmap(region_, sizeof(MtopShm::Region));
+        // unlink while still holding the lock, so no new writer ends up with the removed file
+        unlink(path_.c_str());
+    }
+    if (fd_ >= 0) close(fd_);
+}
+
+bool ShmExporter::Open(std::string& error) {
+    int fd = open(path_.c_str(), O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        error = path_ + ": " + std::strerror(errno);
+        return false;
+    }
+    // /dev/shm is shared by everyone: only ever write into a regular file of our own
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_uid != geteuid()) {
+        error = path_ + ": not a regular file owned by this user";
+        close(fd);
+        return false;
+    }
+    // a file left behind by a dead writer is fine to reuse, a live one is not
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        error = errno == EWOULDBLOCK ? "another mtop is already exporting to " + path_
+                                     : path_ + ": " + std::strerror(errno);
+        close(fd);
+        return false;
+    }
+    if (ftruncate(fd, sizeof(MtopShm::Region)) != 0) {
+        error = path_ + ": " + std::strerror(errno);
+        close(fd);
+        return false;
+    }
+    void* map = mmap(nullptr, sizeof(MtopShm::Region), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        error = path_ + ": " + std::strerror(errno);
+        close(fd);
+        return false;
+    }
+    fd_ = fd;
+
+    // we hold the lock, so a leftover file is from a dead run and may hold anything: start clean
+    std::memset(map, 0, sizeof(MtopShm::Region));
+    region_ = new (map) MtopShm::Region;
+    MtopShm::Header& h = region_->header;
+    h.version = MtopShm::kVersion;
+    h.slot_count = MtopShm::kSlots;
+    h.slot_size = sizeof(MtopShm::Slot);
+    h.latest.store(0, std::memory_order_relaxed);
+    for (auto& slot : region_->slots) slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    h.magic = MtopShm::kMagic;
+    return true;
+}
+
+void ShmExporter::Publish(const Snapshot& snap) {
+    if (!region_) return;
+    const uint64_t next = published_ + 1;
+    MtopShm::Slot& slot = region_->slots[next % MtopShm::kSlots];
+
+    // seqlock: odd while the slot is being rewritten
+    const uint64_t seq = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    MtopShm::Snapshot& out = slot.data;
+    out.seq = snap.seq;
+    out.uptime = snap.uptime;
+    out.total_cpu = snap.total_cpu;
+    out.mem_used = snap.mem_used;
+    out.tcp_retrans = snap.tcp_retrans;
+
+    out.core_count = static_cast<uint32_t>(std::min<size_t>(snap.cores.size(), MtopShm::kMaxCores));
+    std::copy_n(snap.cores.begin(), out.core_count, out.cores);
+    for (uint32_t i = 0; i < out.core_count; ++i) {
+        out.core_ids[i] = i < snap.core_ids.size() ? snap.core_ids[i] : static_cast<int32_t>(i);
+        out.core_nodes[i] = i < snap.core_nodes.size() ? snap.core_nodes[i] : 0;
+    }
+
+    out.interface_count = static_cast<uint32_t>(std::min<size_t>(snap.interfaces.size(), MtopShm::kMaxInterfaces));
+    for (uint32_t i = 0; i < out.interface_count; ++i) {
+        const Network::Interface& in = snap.interfaces[i];
+        MtopShm::Interface& iface = out.interfaces[i];
+        CopyString(iface.name, in.name);
+        iface.active = in.active ? 1 : 0;
+        iface.generation = in.generation;
+        iface.rx_bytes = in.rx_bytes;
+        iface.tx_bytes = in.tx_bytes;
+        iface.rx_packets = in.rx_packets;
+        iface.tx_packets = in.tx_packets;
+        iface.errors = in.errors;
+        iface.drops = in.drops;
+    }
+
+    out.process_count = static_cast<uint32_t>(std::min<size_t>(snap.procs.size(), MtopShm::kMaxProcesses));
+    for (uint32_t i = 0; i < out.process_count; ++i) {
+        const ProcessRow& in = snap.procs[i];
+        MtopShm::Process& proc = out.processes[i];
+        proc.pid = in.pid;
+        proc.cpu = in.cpu;
+        proc.ram_kb = in.ram_kb;
+        CopyString(proc.user, in.user);
+        CopyString(proc.command, in.command);
+    }
+
+    slot.sequence.store(seq + 2, std::memory_order_release);
+    region_->header.latest.store(next, std::memory_order_release);
+    published_ = next;
+}
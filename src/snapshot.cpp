@@ -0,0 +1,352 @@
+#include "../include/snapshot.hpp"
+#include <cmath>
+#include <unordered_map>
+
+namespace {
+    const char kKeyframe = 'K';
+    const char kDelta = 'D';
+
+    enum InterfaceFlags : uint8_t { kIdentity = 1, kRates = 2 };
+    enum ProcessFlags : uint8_t { kCpu = 1, kRam = 2, kUser = 4, kCommand = 8, kStart = 16, kIo = 32, kGeneration = 64 };
+    const uint8_t kAllProcessFields = kCpu | kRam | kUser | kCommand | kStart | kIo | kGeneration;
+
+    uint64_t Fraction(float v) { return static_cast<uint64_t>(std::lround(std::max(0.f, v) * 10000.f)); }
+    uint64_t Whole(float v) { return static_cast<uint64_t>(std::llround(std::max(0.f, v))); }
+    float FromFraction(uint64_t v) { return static_cast<float>(v) / 10000.f; }
+    // io rates travel shifted by one so the unknown rate (-1) is 0
+    uint64_t IoRate(float v) { return v < 0.f ? 0 : Whole(v) + 1; }
+    float FromIoRate(uint64_t v) { return v == 0 ? -1.f : static_cast<float>(v - 1); }
+
+    class Writer {
+        public:
+            explicit Writer(std::string& out) : out_(out) {}
+            void Byte(uint8_t b) { out_.push_back(static_cast<char>(b)); }
+            void Varint(uint64_t v) {
+                while (v >= 0x80) {
+                    Byte(static_cast<uint8_t>(v | 0x80));
+                    v >>= 7;
+                }
+                Byte(static_cast<uint8_t>(v));
+            }
+            void Zigzag(int64_t v) { Varint((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63)); }
+            void String(const std::string& s) {
+                Varint(s.size());
+                out_.append(s);
+            }
+        private:
+            std::string& out_;
+    };
+
+    class Reader {
+        public:
+            Reader(const char* data, size_t size) : p_(data), end_(data + size) {}
+            bool Ok() const { return ok_; }
+            uint8_t Byte() {
+                if (p_ >= end_) { ok_ = false; return 0; }
+                return static_cast<uint8_t>(*p_++);
+            }
+            uint64_t Varint() {
+                uint64_t v = 0;
+                for (int shift = 0; shift < 64 && ok_; shift += 7) {
+                    uint8_t b = Byte();
+                    v |= static_cast<uint64_t>(b & 0x7f) << shift;
+                    if (!(b & 0x80)) return v;
+                }
+                ok_ = false;
+                return 0;
+            }
+            int64_t Zigzag() {
+                uint64_t v = Varint();
+                return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+            }
+            void String(std::string& s) {
+                uint64_t n = Varint();
+                if (!ok_ || n > static_cast<uint64_t>(end_ - p_)) { ok_ = false; return; }
+                s.assign(p_, n);
+                p_ += n;
+            }
+        private:
+            const char* p_;
+            const char* end_;
+            bool ok_{true};
+    };
+
+    // a per cpu series: differences against the previous sample, or plain values when the count changed
+    void PutSeries(Writer& w, const std::vector<float>& curr, const std::vector<float>& base) {
+        const bool same = base.size() == curr.size();
+        w.Varint(curr.size());
+        w.Byte(same ? 1 : 0);
+        for (size_t i = 0; i < curr.size(); ++i) {
+            if (same) w.Zigzag(static_cast<int64_t>(Fraction(curr[i])) - static_cast<int64_t>(Fraction(base[i])));
+            else w.Varint(Fraction(curr[i]));
+        }
+    }
+
+    bool GetSeries(Reader& r, const std::vector<float>& base, std::vector<float>& out, size_t limit) {
+        const uint64_t n = r.Varint();
+        const bool same = r.Byte() == 1;
+        if (!r.Ok() || n > limit || (same && n != base.size())) return false;
+        out.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = same ? FromFraction(static_cast<uint64_t>(static_cast<int64_t>(Fraction(base[i])) + r.Zigzag()))
+                          : FromFraction(r.Varint());
+        }
+        return r.Ok();
+    }
+
+    bool SameIdentity(const Network::Interface& a, const Network::Interface& b) {
+        return a.active == b.active && a.generation == b.generation && a.name == b.name;
+    }
+
+    bool SameRates(const Network::Interface& a, const Network::Interface& b) {
+        return Whole(a.rx_bytes) == Whole(b.rx_bytes) && Whole(a.tx_bytes) == Whole(b.tx_bytes) &&
+               Whole(a.rx_packets) == Whole(b.rx_packets) && Whole(a.tx_packets) == Whole(b.tx_packets) &&
+               Whole(a.errors) == Whole(b.errors) && Whole(a.drops) == Whole(b.drops);
+    }
+}; // namespace
+
+void SnapshotCodec::Encode(const Snapshot& curr, const Snapshot* prev, std::string& out) {
+    static const Snapshot kEmpty;
+    const Snapshot& base = prev ? *prev : kEmpty;
+    out.clear();
+    Writer w(out);
+
+    w.Byte(prev ? kDelta : kKeyframe);
+    if (!prev) w.Byte(kVersion);
+    w.Varint(curr.seq);
+    w.Varint(Fraction(curr.total_cpu));
+    w.Varint(Fraction(curr.mem_used));
+    w.Varint(static_cast<uint64_t>(std::max(0L, curr.uptime)));
+    w.Varint(Whole(curr.tcp_retrans));
+
+    PutSeries(w, curr.cores, base.cores);
+    PutSeries(w, curr.core_user, base.core_user);
+    PutSeries(w, curr.core_system, base.core_system);
+    PutSeries(w, curr.core_iowait, base.core_iowait);
+    PutSeries(w, curr.core_steal, base.core_steal);
+    // the cpu ids and nodes only change with hotplug
+    const bool same_layout = base.core_ids == curr.core_ids && base.core_nodes == curr.core_nodes;
+    w.Byte(same_layout ? 1 : 0);
+    if (!same_layout) {
+        w.Varint(curr.core_ids.size());
+        for (int id : curr.core_ids) w.Varint(static_cast<uint64_t>(std::max(0, id)));
+        w.Varint(curr.core_nodes.size());
+        for (int node : curr.core_nodes) w.Varint(static_cast<uint64_t>(std::max(0, node)));
+    }
+
+    w.Varint(curr.interfaces.size());
+    for (size_t i = 0; i < curr.interfaces.size(); ++i) {
+        const Network::Interface& iface = curr.interfaces[i];
+        const Network::Interface* old = i < base.interfaces.size() ? &base.interfaces[i] : nullptr;
+        uint8_t flags = 0;
+        if (!old || !SameIdentity(*old, iface)) flags |= kIdentity;
+        if (!old || !SameRates(*old, iface)) flags |= kRates;
+        w.Byte(flags);
+        if (flags & kIdentity) {
+            w.String(iface.name);
+            w.Byte(iface.active ? 1 : 0);
+            w.Varint(iface.generation);
+        }
+        if (flags & kRates) {
+            w.Varint(Whole(iface.rx_bytes));
+            w.Varint(Whole(iface.tx_bytes));
+            w.Varint(Whole(iface.rx_packets));
+            w.Varint(Whole(iface.tx_packets));
+            w.Varint(Whole(iface.errors));
+            w.Varint(Whole(iface.drops));
+        }
+    }
+
+    // processes by pid: which ones are gone, the new rows and the changed fields of known ones,
+    // then the order as runs over the previous order (new rows appended in their new order).
+    // unchanged rows cost nothing and an unchanged order is a single run
+    std::unordered_map<int, const ProcessRow*> known;
+    known.reserve(base.procs.size());
+    for (const ProcessRow& row : base.procs) known.emplace(row.pid, &row);
+
+    std::unordered_map<int, size_t> source;  // pid -> position in base order minus removed, then new
+    source.reserve(curr.procs.size());
+    for (const ProcessRow& row : curr.procs) source.emplace(row.pid, 0);
+    std::vector<int> removed;
+    size_t kept = 0;
+    for (const ProcessRow& row : base.procs) {
+        auto it = source.find(row.pid);
+        if (it == source.end()) removed.push_back(row.pid);
+        else it->second = kept++;
+    }
+    w.Varint(removed.size());
+    for (int pid : removed) w.Varint(static_cast<uint64_t>(pid));
+
+    size_t changed = 0;
+    std::string rows;
+    Writer rw(rows);
+    for (const ProcessRow& row : curr.procs) {
+        auto it = known.find(row.pid);
+        const ProcessRow* old = it == known.end() ? nullptr : it->second;
+        if (!old) source[row.pid] = kept++;
+        uint8_t flags = 0;
+        if (!old || Fraction(old->cpu) != Fraction(row.cpu)) flags |= kCpu;
+        if (!old || old->ram_kb != row.ram_kb) flags |= kRam;
+        if (!old || old->user != row.user) flags |= kUser;
+        if (!old || old->command != row.command) flags |= kCommand;
+        if (!old || old->start != row.start) flags |= kStart;
+        if (!old || IoRate(old->io) != IoRate(row.io)) flags |= kIo;
+        if (!old || old->generation != row.generation) flags |= kGeneration;
+        if (!flags) continue;
+        ++changed;
+        rw.Varint(static_cast<uint64_t>(row.pid));
+        rw.Byte(flags);
+        if (flags & kCpu) rw.Varint(Fraction(row.cpu));
+        if (flags & kRam) rw.Varint(static_cast<uint64_t>(std::max(0L, row.ram_kb)));
+        if (flags & kUser) rw.String(row.user);
+        if (flags & kCommand) rw.String(row.command);
+        if (flags & kStart) rw.Varint(static_cast<uint64_t>(std::max(0L, row.start)));
+        if (flags & kIo) rw.Varint(IoRate(row.io));
+        if (flags & kGeneration) rw.Varint(row.generation);
+    }
+    w.Varint(changed);
+    out.append(rows);
+
+    // (start, length) runs of consecutive source positions, starts relative to the previous run's end
+    std::vector<std::pair<size_t, size_t>> runs;
+    for (const ProcessRow& row : curr.procs) {
+        const size_t at = source[row.pid];
+        if (!runs.empty() && runs.back().first + runs.back().second == at) ++runs.back().second;
+        else runs.emplace_back(at, 1);
+    }
+    w.Varint(runs.size());
+    size_t end = 0;
+    for (const auto& [start, length] : runs) {
+        w.Zigzag(static_cast<int64_t>(start) - static_cast<int64_t>(end));
+        w.Varint(length);
+        end = start + length;
+    }
+}
+
+bool SnapshotCodec::Decode(const char* data, size_t size, Snapshot& state) {
+    Reader r(data, size);
+    const char kind = static_cast<char>(r.Byte());
+    if (kind == kKeyframe) {
+        if (r.Byte() != kVersion) return false;
+    } else if (kind != kDelta) {
+        return false;
+    }
+
+    Snapshot next;
+    next.seq = r.Varint();
+    if (kind == kDelta && next.seq != state.seq + 1) return false;
+    // whatever happens below, a failed message leaves an empty state that only a keyframe can resume
+    Snapshot base;
+    if (kind == kDelta) base = std::move(state);
+    state = Snapshot{};
+    next.total_cpu = FromFraction(r.Varint());
+    next.mem_used = FromFraction(r.Varint());
+    next.uptime = static_cast<long>(r.Varint());
+    next.tcp_retrans = static_cast<float>(r.Varint());
+
+    if (!GetSeries(r, base.cores, next.cores, size) || !GetSeries(r, base.core_user, next.core_user, size) ||
+        !GetSeries(r, base.core_system, next.core_system, size) || !GetSeries(r, base.core_iowait, next.core_iowait, size) ||
+        !GetSeries(r, base.core_steal, next.core_steal, size)) {
+        return false;
+    }
+    if (r.Byte() == 1) {
+        next.core_ids = base.core_ids;
+        next.core_nodes = base.core_nodes;
+    } else {
+        const uint64_t ids = r.Varint();
+        if (!r.Ok() || ids > size) return false;
+        next.core_ids.resize(ids);
+        for (auto& id : next.core_ids) id = static_cast<int>(r.Varint());
+        const uint64_t nodes = r.Varint();
+        if (!r.Ok() || nodes > size) return false;
+        next.core_nodes.resize(nodes);
+        for (auto& node : next.core_nodes) node = static_cast<int>(r.Varint());
+    }
+
+    const uint64_t ifaces = r.Varint();
+    if (!r.Ok() || ifaces > size) return false;
+    next.interfaces.resize(ifaces);
+    for (size_t i = 0; i < ifaces; ++i) {
+        Network::Interface& iface = next.interfaces[i];
+        if (i < base.interfaces.size()) iface = base.interfaces[i];
+        const uint8_t flags = r.Byte();
+        if (!(flags & kIdentity) && i >= base.interfaces.size()) return false;
+        if (!(flags & kRates) && i >= base.interfaces.size()) return false;
+        if (flags & kIdentity) {
+            r.String(iface.name);
+            iface.active = r.Byte() == 1;
+            iface.generation = static_cast<unsigned>(r.Varint());
+        }
+        if (flags & kRates) {
+            iface.rx_bytes = static_cast<float>(r.Varint());
+            iface.tx_bytes = static_cast<float>(r.Varint());
+            iface.rx_packets = static_cast<float>(r.Varint());
+            iface.tx_packets = static_cast<float>(r.Varint());
+            iface.errors = static_cast<float>(r.Varint());
+            iface.drops = static_cast<float>(r.Varint());
+        }
+    }
+
+    // base rows are moved into the new snapshot, the decoder owns them now
+    std::unordered_map<int, ProcessRow*> known;
+    known.reserve(base.procs.size());
+    for (ProcessRow& row : base.procs) known.emplace(row.pid, &row);
+    const uint64_t removed = r.Varint();
+    if (!r.Ok() || removed > size) return false;
+    for (uint64_t i = 0; i < removed; ++i) known.erase(static_cast<int>(r.Varint()));
+
+    std::vector<ProcessRow*> source;  // base order minus removed, then the new rows
+    source.reserve(known.size());
+    for (ProcessRow& row : base.procs) {
+        if (known.count(row.pid)) source.push_back(&row);
+    }
+    const uint64_t changed = r.Varint();
+    if (!r.Ok() || changed > size) return false;
+    std::vector<ProcessRow> added;
+    for (uint64_t i = 0; i < changed; ++i) {
+        const int pid = static_cast<int>(r.Varint());
+        const uint8_t flags = r.Byte();
+        auto it = known.find(pid);
+        ProcessRow* row = nullptr;
+        if (it != known.end()) {
+            row = it->second;
+        } else {
+            if (flags != kAllProcessFields) return false;
+            added.emplace_back();
+            row = &added.back();
+            row->pid = pid;
+        }
+        if (flags & kCpu) row->cpu = FromFraction(r.Varint());
+        if (flags & kRam) row->ram_kb = static_cast<long>(r.Varint());
+        if (flags & kUser) r.String(row->user);
+        if (flags & kCommand) r.String(row->command);
+        if (flags & kStart) row->start = static_cast<long>(r.Varint());
+        if (flags & kIo) row->io = FromIoRate(r.Varint());
+        if (flags & kGeneration) row->generation = static_cast<unsigned>(r.Varint());
+        if (!r.Ok()) return false;
+    }
+    for (ProcessRow& row : added) source.push_back(&row);
+
+    const uint64_t runs = r.Varint();
+    if (!r.Ok() || runs > size) return false;
+    next.procs.reserve(source.size());
+    std::vector<char> used(source.size(), 0);
+    int64_t end = 0;
+    for (uint64_t i = 0; i < runs; ++i) {
+        const int64_t start = end + r.Zigzag();
+        const uint64_t length = r.Varint();
+        if (!r.Ok() || start < 0 || length > source.size() || static_cast<uint64_t>(start) > source.size() - length) return false;
+        for (uint64_t k = 0; k < length; ++k) {
+            const size_t at = static_cast<size_t>(start) + k;
+            if (used[at]) return false;
+            used[at] = 1;
+            next.procs.push_back(std::move(*source[at]));
+        }
+        end = start + static_cast<int64_t>(length);
+    }
+    if (next.procs.size() != source.size()) return false;
+
+    if (!r.Ok()) return false;
+    state = std::move(next);
+    return true;
+}
@@ -0,0 +1,200 @@
+#include "../include/snapshot_feed.hpp"
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    const size_t kMaxFrame = 64 << 20;
+
+    bool MakeAddress(const std::string& path, sockaddr_un& addr, std::string& error) {
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+            error = "socket path is empty or too long: " + path;
+            return false;
+        }
+        std::memcpy(addr.sun_path, path.c_str(), path.size());
+        return true;
+    }
+
+    void PutLength(char* out, uint32_t n) {
+        for (int i = 0; i < 4; ++i) out[i] = static_cast<char>((n >> (8 * i)) & 0xff);
+    }
+
+    uint32_t GetLength(const char* in) {
+        uint32_t n = 0;
+        for (int i = 0; i < 4; ++i) n |= static_cast<uint32_t>(static_cast<uint8_t>(in[i])) << (8 * i);
+        return n;
+    }
+}; // namespace
+
+SnapshotServer::SnapshotServer(std::string path) : path_(std::move(path)) {}
+
+SnapshotServer::~SnapshotServer() {
+    for (auto& viewer : viewers_) close(viewer.fd);
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        unlink(path_.c_str());
+    }
+}
+
+size_t SnapshotServer::Viewers() const { return viewers_.size(); }
+
+bool SnapshotServer::Listen(std::string& error) {
+    sockaddr_un addr;
+    if (!MakeAddress(path_, addr, error)) return false;
+
+    // a socket file left behind by a dead server is fine to replace, a live one is not
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe >= 0) {
+        bool live = connect(probe, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+        close(probe);
+        if (live) {
+            error = "another mtop is already serving on " + path_;
+            return false;
+        }
+    }
+    unlink(path_.c_str());
+
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (listen_fd_ < 0 || bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(listen_fd_, 16) != 0) {
+        error = path_ + ": " + std::strerror(errno);
+        if (listen_fd_ >= 0) close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    chmod(path_.c_str(), 0666);
+    return true;
+}
+
+void SnapshotServer::Accept() {
+    while (true) {
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) break;
+        viewers_.push_back(Viewer{fd, true, {}});
+    }
+}
+
+bool SnapshotServer::Flush(Viewer& viewer) {
+    while (!viewer.pending.empty()) {
+        ssize_t n = send(viewer.fd, viewer.pending.data(), viewer.pending.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        viewer.pending.erase(0, static_cast<size_t>(n));
+    }
+    return true;
+}
+
+void SnapshotServer::Publish(const Snapshot& snap) {
+    if (listen_fd_ < 0) return;
+    Accept();
+
+    bool encoded_key = false, encoded_delta = false;
+    for (size_t i = 0; i < viewers_.size();) {
+        Viewer& viewer = viewers_[i];
+        bool alive = Flush(viewer);
+        if (alive && viewer.pending.empty()) {
+            // still mid-frame viewers miss this delta, and resync with a keyframe later
+            bool key = viewer.needs_keyframe || !have_prev_;
+            if (key && !encoded_key) {
+                SnapshotCodec::Encode(snap, nullptr, keyframe_);
+                encoded_key = true;
+            } else if (!key && !encoded_delta) {
+                SnapshotCodec::Encode(snap, &prev_, delta_);
+                encoded_delta = true;
+            }
+            const std::string& frame = key ? keyframe_ : delta_;
+            char header[4];
+            PutLength(header, static_cast<uint32_t>(frame.size()));
+            iovec iov[2] = {{header, sizeof(header)}, {const_cast<char*>(frame.data()), frame.size()}};
+            msghdr msg{};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = 2;
+            ssize_t n = sendmsg(viewer.fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                alive = false;
+            } else {
+                size_t sent = n < 0 ? 0 : static_cast<size_t>(n);
+                // only the unsent tail is copied, and only for a viewer that fell behind
+                if (sent < sizeof(header)) viewer.pending.assign(header + sent, sizeof(header) - sent);
+                size_t body = sent > sizeof(header) ? sent - sizeof(header) : 0;
+                if (body < frame.size()) viewer.pending.append(frame, body, std::string::npos);
+                viewer.needs_keyframe = false;
+            }
+        } else if (alive) {
+            viewer.needs_keyframe = true;
+        }
+
+        if (!alive) {
+            close(viewer.fd);
+            viewers_[i] = std::move(viewers_.back());
+            viewers_.pop_back();
+            continue;
+        }
+        ++i;
+    }
+
+    prev_ = snap;
+    have_prev_ = true;
+}
+
+SnapshotClient::SnapshotClient(std::string path) : path_(std::move(path)) {}
+
+SnapshotClient::~SnapshotClient() {
+    if (fd_ >= 0) close(fd_);
+}
+
+bool SnapshotClient::Connect(std::string& error) {
+    sockaddr_un addr;
+    if (!MakeAddress(path_, addr, error)) return false;
+    if (fd_ >= 0) close(fd_);
+    buffer_.clear();
+    fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0 || connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        error = path_ + ": " + std::strerror(errno);
+        if (fd_ >= 0) close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    // anyone can bind a path in /tmp first: only trust a server run by us or by root
+    ucred peer{};
+    socklen_t len = sizeof(peer);
+    if (getsockopt(fd_, SOL_SOCKET, SO_PEERCRED, &peer, &len) != 0 || (peer.uid != getuid() && peer.uid != 0)) {
+        error = path_ + ": server is not run by this user or root";
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    return true;
+}
+
+bool SnapshotClient::Receive(Snapshot& snap) {
+    if (fd_ < 0) return false;
+    char chunk[64 * 1024];
+    while (true) {
+        if (buffer_.size() >= 4) {
+            uint32_t size = GetLength(buffer_.data());
+            if (size > kMaxFrame) return false;
+            if (buffer_.size() >= 4 + size) {
+                bool ok = SnapshotCodec::Decode(buffer_.data() + 4, size, snap);
+                buffer_.erase(0, 4 + size);
+                return ok;
+            }
+        }
+        ssize_t n = recv(fd_, chunk, sizeof(chunk), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        buffer_.append(chunk, static_cast<size_t>(n));
+    }
+}
+
+void SnapshotClient::Shutdown() {
+    if (fd_ >= 0) shutdown(fd_, SHUT_RDWR);
+}
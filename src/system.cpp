@@ -1,14 +1,33 @@
 #include "../include/system.hpp"
 #include "../include/linux_parser.hpp"
+#include "../include/utils.hpp"
+#include <chrono>
 
 Processor& System::Cpu() { return cpu_; }
 
 std::vector<Process>& System::Processes() {
-    processes_.clear();
+    cycle_.uptime = LinuxParser::UpTime();
+    cycle_.now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    cycle_.hertz = sysconf(_SC_CLK_TCK);
+    cycle_.page_kb = sysconf(_SC_PAGESIZE) / 1024;
+
+    // walk the survivors in last cycle's order, new pids go to the back
+    spare_.clear();
+    for (Process& p : processes_) {
+        if (p.Update(cycle_)) spare_.push_back(std::move(p));
+    }
+    processes_.swap(spare_);
+    known_.clear();
+    for (const Process& p : processes_) known_.insert(p.Pid());
     for (int pid : LinuxParser::Pids()) {
-        processes_.emplace_back(pid);
+        if (known_.count(pid)) continue;
+        Process p(pid);
+        if (p.Update(cycle_)) processes_.push_back(std::move(p));
     }
-    std::sort(processes_.begin(), processes_.end(), [](const Process& a, const Process& b){
+
+    // a share only changes when its process completes a rate interval, so between two cycles
+    // few entries move and this is mostly a linear pass
+    Utils::AdaptiveSort(processes_.begin(), processes_.end(), [](const Process& a, const Process& b){
         return b < a;
     });
     return processes_;
@@ -0,0 +1,85 @@
+#include "../include/task_table.hpp"
+#include "../include/utils.hpp"
+#include <chrono>
+#include <cstdio>
+#include <numeric>
+#include <unistd.h>
+
+TaskTable::TaskTable(int pid) : pid_(pid), hertz_(sysconf(_SC_CLK_TCK)) {}
+
+int TaskTable::Pid() const { return pid_; }
+const std::vector<TaskTable::Thread>& TaskTable::Threads() const { return threads_; }
+const std::vector<int>& TaskTable::ByCpu() const { return by_cpu_; }
+
+bool TaskTable::Read(size_t slot, double dt) {
+    Thread& thread = threads_[slot];
+    Sample& sample = samples_[slot];
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/%d/task/%d/stat", pid_, thread.tid);
+    if (!LinuxParser::ReadPath(path, buf_) || !LinuxParser::ParseProcStat(buf_, stat_)) return false;
+
+    thread.name = stat_.comm;
+    thread.state = stat_.state;
+    thread.processor = stat_.processor;
+    const unsigned long long ticks = static_cast<unsigned long long>(stat_.utime + stat_.stime);
+    // a new start time is a new thread (or a reused tid), it has no interval yet
+    if (stat_.starttime != sample.starttime || ticks < sample.ticks || dt <= 0.0) {
+        thread.cpu = 0.f;
+    } else {
+        thread.cpu = static_cast<float>(static_cast<double>(ticks - sample.ticks) / static_cast<double>(hertz_) / dt);
+    }
+    sample.starttime = stat_.starttime;
+    sample.ticks = ticks;
+    return true;
+}
+
+bool TaskTable::Update() {
+    if (!LinuxParser::Tids(pid_, tids_)) return false;
+    // the kernel lists tasks in tid order already
+    Utils::AdaptiveSort(tids_.begin(), tids_.end(), [](int a, int b) { return a < b; });
+
+    const double now = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    const double dt = last_ > 0.0 ? now - last_ : 0.0;
+    last_ = now;
+
+    // drop the threads that exited, compacting in place
+    size_t kept = 0;
+    size_t j = 0;
+    for (size_t i = 0; i < threads_.size(); ++i) {
+        while (j < tids_.size() && tids_[j] < threads_[i].tid) ++j;
+        if (j == tids_.size() || tids_[j] != threads_[i].tid) continue;
+        if (kept != i) {
+            std::swap(threads_[kept], threads_[i]);
+            samples_[kept] = samples_[i];
+        }
+        ++kept;
+    }
+    threads_.resize(kept);
+    samples_.resize(kept);
+
+    // walk both lists in tid order, new threads are mostly the highest tids and land at the back
+    size_t k = 0;
+    for (int tid : tids_) {
+        while (k < threads_.size() && threads_[k].tid < tid) ++k;
+        if (k == threads_.size() || threads_[k].tid != tid) {
+            threads_.insert(threads_.begin() + k, Thread{});
+            samples_.insert(samples_.begin() + k, Sample{});
+            threads_[k].tid = tid;
+        }
+        if (Read(k, dt)) {
+            ++k;
+        } else {
+            // exited between the directory scan and the read
+            threads_.erase(threads_.begin() + k);
+            samples_.erase(samples_.begin() + k);
+        }
+    }
+
+    by_cpu_.resize(threads_.size());
+    std::iota(by_cpu_.begin(), by_cpu_.end(), 0);
+    std::sort(by_cpu_.begin(), by_cpu_.end(), [&](int a, int b) {
+        if (threads_[a].cpu != threads_[b].cpu) return threads_[a].cpu > threads_[b].cpu;
+        return threads_[a].tid < threads_[b].tid;
+    });
+    return true;
+}
@@ -10,4 +10,16 @@ std::string Utils::ElapsedTime(long times) {
         << std::setw(2) << std::setfill('0') << m << ":"
         << std::setw(2) << std::setfill('0') << s;
     return oss.str();
+}
+
+std::string Utils::HumanBytes(double bytes) {
+    const char* units = "BKMGTP";
+    int unit = 0;
+    while (bytes >= 1024.0 && unit < 5) {
+        bytes /= 1024.0;
+        ++unit;
+    }
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(unit == 0 ? 0 : 1) << bytes << units[unit];
+    return oss.str();
 }
\ No newline at end of file